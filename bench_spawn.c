@@ -0,0 +1,115 @@
+/*
+ ghstatus spawn benchmark
+   usage: bench_spawn [-n spawns] [-c concurrency] [-m ballast-mb]
+   Starts `true` through ghstatus's spawn_reader() and through the fork()
+   launcher it replaced, with -c children outstanding and -m MB of touched
+   heap standing in for the screen and repo table, and prints one JSON object
+   of spawns per second on stdout.
+   build: gcc bench_spawn.c -o bench_spawn -lncursesw -lssl -lcrypto
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#define main ghstatus_main
+#include "ghstatus.c"
+#undef main
+
+// The launcher as it was before posix_spawn: fork(), then fd surgery and a
+// fresh open of /dev/null in the child.
+pid_t fork_reader(char *const argv[], int *out) {
+  int fds[2];
+  if (pipe2(fds, O_CLOEXEC) == -1)
+    return -1;
+  pid_t pid = fork();
+  if (pid == -1) {
+    close(fds[0]);
+    close(fds[1]);
+    return -1;
+  }
+  if (pid == 0) {
+    sigset_t none;
+    sigemptyset(&none);
+    sigprocmask(SIG_SETMASK, &none, NULL);
+    signal(SIGPIPE, SIG_DFL);
+    dup2(fds[1], STDOUT_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+    if (devnull >= 0) {
+      dup2(devnull, STDERR_FILENO);
+      close(devnull);
+    }
+    execvp(argv[0], argv);
+    _exit(1);
+  }
+  close(fds[1]);
+  *out = fds[0];
+  return pid;
+}
+
+// Runs count children, concurrency at a time, each read to EOF and waited
+// for. Returns spawns per second.
+double run(pid_t (*spawn)(char *const[], int *), int count, int concurrency) {
+  char *argv[] = {"true", NULL};
+  pid_t pids[256];
+  int fds[256];
+  long long start = now_us();
+  int started = 0, done = 0;
+  for (; started < concurrency && started < count; started++)
+    pids[started] = spawn(argv, &fds[started]);
+  for (int k = 0; done < count; k = (k + 1) % concurrency) {
+    if (k >= started)
+      continue;
+    char buf[64];
+    while (read(fds[k], buf, sizeof(buf)) > 0) {
+    }
+    close(fds[k]);
+    waitpid(pids[k], NULL, 0);
+    done++;
+    if (started < count) {
+      pids[k] = spawn(argv, &fds[k]);
+      started++;
+    }
+  }
+  return count * 1e6 / (now_us() - start);
+}
+
+int main(int argc, char **argv) {
+  int count = 2000, concurrency = 32, ballast_mb = 256, opt;
+  while ((opt = getopt(argc, argv, "n:c:m:h")) != -1) {
+    switch (opt) {
+    case 'n':
+      count = atoi(optarg);
+      break;
+    case 'c':
+      concurrency = atoi(optarg);
+      break;
+    case 'm':
+      ballast_mb = atoi(optarg);
+      break;
+    default:
+      fprintf(stderr,
+              "Usage: %s [-n spawns] [-c concurrency] [-m ballast-mb]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+  if (count < 1 || concurrency < 1 || concurrency > 256 || ballast_mb < 0) {
+    fprintf(stderr, "Need -n >= 1, -c 1-256 and -m >= 0.\n");
+    return 1;
+  }
+
+  size_t size = (size_t)ballast_mb << 20;
+  char *ballast = malloc(size ? size : 1);
+  if (!ballast) {
+    perror("malloc");
+    return 1;
+  }
+  memset(ballast, 1, size); // resident, so fork() has page tables to copy
+
+  double forked = run(fork_reader, count, concurrency);
+  double spawned = run(spawn_reader, count, concurrency);
+  printf("{\"spawns\":%d,\"concurrency\":%d,\"ballast_mb\":%d,"
+         "\"fork_per_s\":%.0f,\"posix_spawn_per_s\":%.0f}\n",
+         count, concurrency, ballast_mb, forked, spawned);
+  free(ballast);
+  return 0;
+}
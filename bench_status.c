@@ -0,0 +1,308 @@
+/*
+ ghstatus benchmark
+   usage: bench_status [-r repos-per-user] [-u users] [-l latency-ms]
+                       [-j jitter-ms] [-e error-pct] [-s response-bytes]
+                       [-c count] [-E gh|workers]
+   Runs ./ghstatus on a pseudo terminal against the bench_gh stub and prints
+   one JSON object of metrics on stdout.
+   build: gcc bench_status.c -o bench_status -lutil
+*/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <pty.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define QUIET_MS 100         // output pause that ends a frame
+#define IDLE_WINDOW_MS 2000  // sampled for idle CPU
+#define PHASE_TIMEOUT_MS 600000
+
+static int pty_fd = -1;
+static pid_t child = -1;
+static int calls_fd = -1;
+static long starts_listed, ends_listed, starts_fetched, ends_fetched;
+static long long pty_bytes;
+
+long long now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+// Drains the pty and the stub's call log, waiting up to wait_ms for output.
+// Returns the bytes the dashboard drew.
+long pump(int wait_ms) {
+  char buf[65536];
+  long drawn = 0;
+  struct pollfd p = {pty_fd, POLLIN, 0};
+  if (poll(&p, 1, wait_ms) > 0) {
+    ssize_t n;
+    while ((n = read(pty_fd, buf, sizeof(buf))) > 0)
+      drawn += n;
+  }
+  pty_bytes += drawn;
+  ssize_t n;
+  while ((n = read(calls_fd, buf, sizeof(buf))) > 0) {
+    for (ssize_t k = 0; k < n; k++) {
+      starts_listed += buf[k] == 'L';
+      ends_listed += buf[k] == 'l';
+      starts_fetched += buf[k] == 'A';
+      ends_fetched += buf[k] == 'a';
+    }
+  }
+  return drawn;
+}
+
+// Pumps until *counter reaches target. Returns the time it took, or -1.
+long long wait_for(long *counter, long target) {
+  long long start = now_ms();
+  while (*counter < target) {
+    if (now_ms() - start > PHASE_TIMEOUT_MS)
+      return -1;
+    pump(5);
+  }
+  return now_ms() - start;
+}
+
+// Sends key and times the redraw it causes, up to the first quiet pause.
+long long frame_ms(char key) {
+  while (pump(QUIET_MS) > 0) {
+  }
+  long long start = now_ms(), last = start;
+  if (write(pty_fd, &key, 1) != 1)
+    return -1;
+  while (now_ms() - last < QUIET_MS) {
+    if (pump(10) > 0)
+      last = now_ms();
+  }
+  return last - start;
+}
+
+// Returns the child's user plus system CPU time in ms.
+long long child_cpu_ms(void) {
+  char path[64], stat[1024];
+  snprintf(path, sizeof(path), "/proc/%d/stat", (int)child);
+  int fd = open(path, O_RDONLY);
+  if (fd == -1)
+    return -1;
+  ssize_t n = read(fd, stat, sizeof(stat) - 1);
+  close(fd);
+  if (n <= 0)
+    return -1;
+  stat[n] = '\0';
+  char *p = strrchr(stat, ')');
+  unsigned long utime = 0, stime = 0;
+  const char *fields = "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu";
+  if (!p || sscanf(p + 2, fields, &utime, &stime) != 2)
+    return -1;
+  return (utime + stime) * 1000LL / sysconf(_SC_CLK_TCK);
+}
+
+// Returns the child's peak resident set size in kB.
+long child_peak_rss_kb(void) {
+  char path[64], line[256];
+  snprintf(path, sizeof(path), "/proc/%d/status", (int)child);
+  FILE *fp = fopen(path, "r");
+  long kb = -1;
+  while (fp && fgets(line, sizeof(line), fp)) {
+    if (sscanf(line, "VmHWM: %ld", &kb) == 1)
+      break;
+  }
+  if (fp)
+    fclose(fp);
+  return kb;
+}
+
+void setenv_int(const char *name, long value) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%ld", value);
+  setenv(name, buf, 1);
+}
+
+int main(int argc, char **argv) {
+  long repos = 100, users = 2, latency = 20, jitter = 0, errors = 0, pad = 0;
+  long count = 32;
+  const char *engine = "gh";
+  int opt;
+  while ((opt = getopt(argc, argv, "r:u:l:j:e:s:c:E:h")) != -1) {
+    switch (opt) {
+    case 'r':
+      repos = atol(optarg);
+      break;
+    case 'u':
+      users = atol(optarg);
+      break;
+    case 'l':
+      latency = atol(optarg);
+      break;
+    case 'j':
+      jitter = atol(optarg);
+      break;
+    case 'e':
+      errors = atol(optarg);
+      break;
+    case 's':
+      pad = atol(optarg);
+      break;
+    case 'c':
+      count = atol(optarg);
+      break;
+    case 'E':
+      engine = optarg;
+      break;
+    default:
+      fprintf(stderr,
+              "Usage: %s [-r repos-per-user] [-u users] [-l latency-ms] "
+              "[-j jitter-ms] [-e error-pct] [-s response-bytes] [-c count] "
+              "[-E gh|workers]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+  if (repos < 1 || users < 1 || users > 64 || count < 1) {
+    fprintf(stderr, "Need at least one repo, 1-64 users and -c >= 1.\n");
+    return 1;
+  }
+
+  // a scratch cache and a bin dir whose gh is the stub
+  char dir[] = "/tmp/ghstatus-bench-XXXXXX", path[PATH_MAX], cwd[PATH_MAX];
+  if (!mkdtemp(dir) || !getcwd(cwd, sizeof(cwd))) {
+    perror("bench setup");
+    return 1;
+  }
+  snprintf(path, sizeof(path), "%s/bin", dir);
+  mkdir(path, 0700);
+  char stub[PATH_MAX + 16], gh[PATH_MAX + 16];
+  snprintf(stub, sizeof(stub), "%s/bench_gh", cwd);
+  snprintf(gh, sizeof(gh), "%s/bin/gh", dir);
+  if (symlink(stub, gh) != 0) {
+    perror(gh);
+    return 1;
+  }
+  char *old_path = getenv("PATH");
+  char new_path[2 * PATH_MAX];
+  snprintf(new_path, sizeof(new_path), "%s:%s", path,
+           old_path ? old_path : "");
+  setenv("PATH", new_path, 1);
+  setenv("XDG_CACHE_HOME", dir, 1);
+  setenv("TERM", "xterm-256color", 1);
+  snprintf(path, sizeof(path), "%s/calls", dir);
+  setenv("BENCH_CALLS", path, 1);
+  calls_fd = open(path, O_RDONLY | O_CREAT | O_NONBLOCK | O_CLOEXEC, 0600);
+  setenv_int("BENCH_REPOS", repos);
+  setenv_int("BENCH_LATENCY_MS", latency);
+  setenv_int("BENCH_JITTER_MS", jitter);
+  setenv_int("BENCH_ERROR_PCT", errors);
+  setenv_int("BENCH_RESPONSE_BYTES", pad);
+
+  char count_arg[32], *args[80] = {"./ghstatus", "-p", "3600", "-c", count_arg,
+                                   "-e", (char *)engine};
+  int nargs = 7;
+  snprintf(count_arg, sizeof(count_arg), "%ld", count);
+  char names[64][16];
+  for (long u = 0; u < users; u++) {
+    snprintf(names[u], sizeof(names[u]), "org%ld", u);
+    args[nargs++] = names[u];
+  }
+  args[nargs] = NULL;
+
+  struct winsize ws = {.ws_row = 60, .ws_col = 200};
+  long long start = now_ms();
+  child = forkpty(&pty_fd, NULL, NULL, &ws);
+  if (child == -1) {
+    perror("forkpty");
+    return 1;
+  }
+  if (child == 0) {
+    execv(args[0], args);
+    perror(args[0]);
+    _exit(127);
+  }
+  fcntl(pty_fd, F_SETFL, O_NONBLOCK);
+
+  long total = repos * users;
+  long long first_frame = -1;
+  while (pty_bytes == 0 && now_ms() - start < PHASE_TIMEOUT_MS)
+    pump(5);
+  first_frame = now_ms() - start;
+  long long discovery = wait_for(&ends_listed, users);
+  if (discovery >= 0)
+    discovery = now_ms() - start;
+  long long first_status = wait_for(&ends_fetched, 1);
+  if (first_status >= 0)
+    first_status = now_ms() - start;
+  long long cold_refresh = wait_for(&ends_fetched, total);
+  if (cold_refresh >= 0)
+    cold_refresh = now_ms() - start;
+
+  // a full refresh started from the keyboard, answered with 304s; the
+  // dashboard ignores refreshes within a second of the last one
+  while (pump(QUIET_MS) > 0 || now_ms() - start < 1100) {
+  }
+  long forks_before = starts_fetched;
+  if (write(pty_fd, " ", 1) != 1)
+    return 1;
+  long long refresh = wait_for(&ends_fetched, ends_fetched + total);
+  long refresh_forks = starts_fetched - forks_before;
+
+  // sort changes reorder every cell
+  long long frame_max = 0, frame_sum = 0;
+  for (int k = 0; k < 3; k++) {
+    long long ms = frame_ms('s');
+    frame_sum += ms;
+    if (ms > frame_max)
+      frame_max = ms;
+  }
+
+  while (pump(QUIET_MS) > 0) {
+  }
+  long long cpu_before = child_cpu_ms(), idle_start = now_ms();
+  while (now_ms() - idle_start < IDLE_WINDOW_MS)
+    pump(50);
+  long long idle_cpu = child_cpu_ms() - cpu_before;
+  long long idle_ms = now_ms() - idle_start;
+
+  long long cpu_ms = child_cpu_ms();
+  long peak_rss = child_peak_rss_kb();
+  if (write(pty_fd, "q", 1) != 1)
+    kill(child, SIGTERM);
+  int status;
+  struct rusage ru;
+  while (wait4(child, &status, WNOHANG, &ru) == 0)
+    pump(20);
+  long long tree_cpu_ms = (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000LL +
+                          (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000;
+
+  printf("{\"engine\":\"%s\",\"repos\":%ld,\"users\":%ld,\"latency_ms\":%ld,"
+         "\"jitter_ms\":%ld,\"error_pct\":%ld,\"response_bytes\":%ld,"
+         "\"concurrency\":%ld,\"first_frame_ms\":%lld,\"discovery_ms\":%lld,"
+         "\"first_status_ms\":%lld,\"cold_refresh_ms\":%lld,"
+         "\"refresh_ms\":%lld,\"refresh_forks\":%ld,\"forks\":%ld,"
+         "\"frame_ms_max\":%lld,\"frame_ms_avg\":%lld,"
+         "\"idle_cpu_ms_per_s\":%.1f,\"cpu_ms\":%lld,"
+         "\"cpu_ms_with_children\":%lld,\"peak_rss_kb\":%ld,"
+         "\"pty_bytes\":%lld,\"exit\":%d}\n",
+         engine, total, users, latency, jitter, errors, pad, count,
+         first_frame, discovery, first_status, cold_refresh, refresh,
+         refresh_forks, starts_listed + starts_fetched, frame_max,
+         frame_sum / 3, idle_ms > 0 ? idle_cpu * 1000.0 / idle_ms : 0.0,
+         cpu_ms, tree_cpu_ms, peak_rss, pty_bytes,
+         WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+
+  snprintf(path, sizeof(path), "rm -rf '%s'", dir);
+  return system(path) == 0 && refresh >= 0 ? 0 : 1;
+}
@@ -1,7 +1,11 @@
 /*
  GitHub Actions Build Monitor
-   usage: ghstatus [-p seconds>=1] [-c count>=1] user1 [user2 [user3 [...]]]
-   build: gcc ghstatus.c -o ghstatus -lncursesw
+   usage: ghstatus [-p seconds>=1] [-c count>=1] [-e gh|workers|http]
+                   [-u api-url] [--listen [host:]port]
+                   [--daemon] [--socket path] [--telemetry file]
+                   user1 [user2 [user3 [...]]]
+          ghstatus --attach [--socket path]
+   build: gcc ghstatus.c -o ghstatus -lncursesw -lssl -lcrypto
 */
 
 #define _GNU_SOURCE
@@ -9,54 +13,119 @@
 #include <errno.h>
 #include <ctype.h>
 #include <fcntl.h>
+#include <getopt.h>
+#include <limits.h>
 #include <locale.h>
 #include <ncursesw/ncurses.h>
-#include <poll.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/ssl.h>
 #include <signal.h>
+#include <spawn.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
 #include <sys/select.h>
+#include <sys/mman.h>
+#include <sys/pidfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
 #include <sys/wait.h>
 #include <time.h>
 #include <unistd.h>
 #include <wchar.h>
 
-#define MAX_REPOS 2048
 #define POLL_INTERVAL_S 300       // seconds between full refresh
 #define SPIN_INTERVAL_MS 125      // ms between spinner frame changes
+#define WHEEL_ROWS 3              // grid rows scrolled per mouse wheel step
+#define WIDE_RUNS 14              // runs sparkline drawn in a wide cell
 #define MAX_CONCURRENT_FETCHES 32 // max number of simultaneous fetches
+#define MAX_HTTP_CONNS 64         // cap on pooled keep-alive connections
+#define MAX_WORKERS 64            // cap on persistent gh worker processes
+#define SNAPSHOT_INTERVAL_S 60    // seconds between snapshot writes
+#define ACTIVE_POLL_S 5           // poll interval while a run is in progress
+#define BACKOFF_BASE_S 30         // first idle poll interval, doubled to -p
+#define REPO_LIST_LIMIT "1000000" // repos listed per user, effectively all
+#define DELTA_LIST_LIMIT "100"    // most recently pushed repos per delta pass
+#define DELTA_SWEEP_FACTOR 48     // idle polls with --delta, in units of -p
+#define RATE_BURST 64             // requests allowed back to back
+#define ARENA_BLOCK 65536         // bytes per repo name arena block
+#define HISTORY_RUNS 32           // runs remembered per repo
+#define HISTORY_PAGE 5            // runs fetched once a repo has history
+#define WORKFLOW_PAGE 50          // runs fetched per repo with --workflows
+#define WORKFLOWS_MAX 16          // workflows listed per repo
+#define FETCH_TEXT_MAX 8192       // status and run history of one fetch
+#define FETCH_STALE_MS 30000      // in flight this long, a refresh cancels it
+#define API_URL "https://api.github.com"
+#define RUNS_JQ                                                                \
+  "if (.workflow_runs | length) == 0 then \"no_runs\" else "                  \
+  "(.workflow_runs[0] | \"\\(.status) \\(.conclusion)\\t\") + "               \
+  "([.workflow_runs[] | \"\\(.id) \\(.status) \\(.conclusion) \\("            \
+  "(.updated_at | fromdate) - ((.run_started_at // .created_at) | "           \
+  "fromdate)) \\(.workflow_id) \\(.head_branch // \"-\" | gsub(\"[; ]\"; "    \
+  "\"_\")) \\(.name // \"\" | gsub(\"[;\\t\\n]\"; \" \"))\"] | join(\";\")) end"
+#define REPO_LIST_JQ                                                           \
+  ".[] | \"\\(.nameWithOwner)\\t\\(.defaultBranchRef.name // \"\")\\t"         \
+  "\\(.pushedAt // \"\")\""
 
-char *REPOS[MAX_REPOS];
-int NUM_REPOS = 0;
-char STATUS[MAX_REPOS][64];
-static char status_buf[MAX_REPOS][128];
-int status_received[MAX_REPOS];
+static bool snapshot_dirty; // statuses changed since the last snapshot
 const wchar_t spinner_chars[] = L"🌑🌒🌓🌔🌕🌖🌗🌘";
 
+// What a status decodes to, in stats bar order.
+typedef enum {
+  ST_SUCCESS,
+  ST_FAILURE,
+  ST_TIMED_OUT,
+  ST_CANCELLED,
+  ST_SKIPPED,
+  ST_IN_PROGRESS,
+  ST_ACTION_REQUIRED,
+  ST_NEUTRAL,
+  ST_STALE,
+  ST_QUEUED,
+  ST_RATE_LIMITED,
+  ST_LOADING,
+  ST_NO_RUNS,
+  ST_UNKNOWN
+} StatusKind;
+
 typedef struct {
   const char *match;
   const wchar_t *icon;
   const char *label;
   int color;
+  int severity; // status sort rank, most urgent first
 } StatusEntry;
 
 StatusEntry status_map[] = {
-    {"success", L"✅", "Conclusion: success", 1},
-    {"failure", L"❌", "Conclusion: failure", 2},
-    {"timed_out", L"⌛", "Conclusion: timed out", 2},
-    {"cancelled", L"🛑", "Conclusion: cancelled", 4},
-    {"skipped", L"⏭️", "Conclusion: skipped", 5},
-    {"in_progress", L"🔁", "Status: in progress", 7},
-    {"action_required", L"⛔", "Status: action required", 6},
-    {"neutral", L"⭕", "Conclusion: neutral", 3},
-    {"stale", L"🥖", "Status: stale", 4},
-    {"queued", L"📋", "Status: queued", 3},
-    {"loading", L"🌀", "Status: loading", 3},
-    {"no_runs", L"🚫", "Status: no runs", 3},
-    {NULL, L"➖", "Unknown status", 3},
+    [ST_SUCCESS] = {"success", L"✅", "Conclusion: success", 1, 10},
+    [ST_FAILURE] = {"failure", L"❌", "Conclusion: failure", 2, 0},
+    [ST_TIMED_OUT] = {"timed_out", L"⌛", "Conclusion: timed out", 2, 1},
+    [ST_CANCELLED] = {"cancelled", L"🛑", "Conclusion: cancelled", 4, 3},
+    [ST_SKIPPED] = {"skipped", L"⏭️", "Conclusion: skipped", 5, 9},
+    [ST_IN_PROGRESS] = {"in_progress", L"🔁", "Status: in progress", 7, 4},
+    [ST_ACTION_REQUIRED] = {"action_required", L"⛔",
+                            "Status: action required", 6, 2},
+    [ST_NEUTRAL] = {"neutral", L"⭕", "Conclusion: neutral", 3, 8},
+    [ST_STALE] = {"stale", L"🥖", "Status: stale", 4, 7},
+    [ST_QUEUED] = {"queued", L"📋", "Status: queued", 3, 5},
+    [ST_RATE_LIMITED] = {"rate_limited", L"🚦", "Status: rate limited", 4, 6},
+    [ST_LOADING] = {"loading", L"🌀", "Status: loading", 3, 12},
+    [ST_NO_RUNS] = {"no_runs", L"🚫", "Status: no runs", 3, 11},
+    [ST_UNKNOWN] = {NULL, L"➖", "Unknown status", 3, 13},
 };
 
 #define STATUS_COUNT (sizeof(status_map) / sizeof(status_map[0]))
@@ -64,213 +133,4299 @@ StatusEntry status_map[] = {
 
 typedef enum { SORT_DEFAULT, SORT_ALPHA, SORT_STATUS } SortMode;
 SortMode sort_mode = SORT_DEFAULT;
+int filter_kind = -1; // StatusKind the grid is narrowed to, or -1 for all
+bool filter_dirty;    // the filtered grid needs rebuilding
+
+typedef enum { ENGINE_GH, ENGINE_WORKERS, ENGINE_HTTP } FetchEngine;
+FetchEngine fetch_engine = ENGINE_GH;
+bool workflow_mode; // cells show the worst of each workflow's latest run
+
+// button hover state
+int hover_x = -1, hover_y = -1;
+
+void apply_sort(void);
+void order_reposition(int i);
+void filter_index_add(int i);
+void filter_index_truncate(int count);
+void filter_free(void);
+long long now_ms(void);
+long long now_us(void);
+int fetches_busy(void);
+void delta_poll(void);
+long long delta_wait_ms(void);
+
+// ---- repo table ----
+
+// Per-repo state is kept in parallel arrays indexed by repo that grow
+// together as repos are added, so memory follows the repo count.
+char **REPOS;  // names, interned in the name arena
+int NUM_REPOS = 0;
+static int repo_cap; // capacity of every per-repo array
+uint16_t *status_id; // interned status text, see repo_status()
+static char **fetch_out; // gh engine output collected so far
+static size_t *fetch_out_len;
+bool *status_received;
+bool *status_stale;  // last known status restored from a snapshot
+bool *repo_dirty;    // cell needs redrawing
+int *ORIGINAL_INDEX; // for restoring original order
+int *order;          // active display order
+int *order_pos;      // position of each repo in order
+bool order_dirty;    // order must be rebuilt by apply_sort()
+static int *alpha_order; // repos sorted by name
+static int *alpha_rank;  // position of each repo in alpha_order
+static bool alpha_dirty; // alpha_order predates the latest repos
+int *drawn_repo;     // repo drawn at each grid position
+int (*pipes)[2];
+pid_t *fetch_pids;
+static int *fetch_queue; // ring of repos waiting for a fetch slot
+static int fetch_qhead, fetch_qlen;
+static bool *fetch_queued;
+static bool *in_flight;    // handed to a connection or worker
+static uint32_t *fetch_gen; // refresh generation the fetch was started in
+static bool *refresh_owed;  // the current refresh still awaits this repo
+static uint32_t fetch_generation; // bumped by each refresh, see spawn_fetches()
+static int refresh_left;          // repos with refresh_owed set
+static int *sched_heap;    // min-heap of repos ordered by next_due
+static int *sched_pos;     // heap position + 1, 0 when not queued
+static long long *next_due; // ms timestamp of the next poll
+static long long *fetch_mark_us; // when the fetch was queued, then started
+static int *poll_backoff_s; // current idle interval, 0 if unset
+static char (*repo_etag)[96];   // ETag of the last 200 response
+static uint16_t *etag_status;  // status parsed from that response, 0 if none
+static bool *discovered;        // listed by the latest discovery
+typedef struct {
+  uint64_t last_id;            // id of the newest run
+  uint8_t start, count;        // ring position of the oldest run, runs held
+  uint8_t runs[HISTORY_RUNS];  // packed, see history_record()
+  uint32_t ids[HISTORY_RUNS];  // low 32 bits of each run's id
+} RunHistory;
+RunHistory *run_history; // latest runs, oldest first
+char **workflow_text;     // latest run per workflow, see workflow_reduce()
+uint16_t *default_branch; // listed default branch, see branch_intern()
+static char **branch_names; // distinct default branches, 0 is unknown
+static int num_branch_names, branch_names_cap;
+static long long *pushed_at; // listed pushedAt in seconds, 0 if unknown
+static int *repo_slots; // name index: open addressing, index + 1 or 0
+static size_t repo_nslots;
+
+static char *arena;       // current block of the name arena
+static size_t arena_used, arena_size;
+
+// Copies name into the arena, which hands out stable pointers and is only
+// freed as a whole. Returns NULL if out of memory.
+char *intern_name(const char *name) {
+  size_t n = strlen(name) + 1;
+  if (!arena || arena_size - arena_used < n) {
+    size_t size = sizeof(char *) + n > ARENA_BLOCK ? sizeof(char *) + n
+                                                   : ARENA_BLOCK;
+    char *block = malloc(size);
+    if (!block)
+      return NULL;
+    memcpy(block, &arena, sizeof(char *)); // chain the previous block
+    arena = block;
+    arena_used = sizeof(char *);
+    arena_size = size;
+  }
+  char *p = arena + arena_used;
+  memcpy(p, name, n);
+  arena_used += n;
+  return p;
+}
+
+void arena_free(void) {
+  while (arena) {
+    char *prev;
+    memcpy(&prev, arena, sizeof(char *));
+    free(arena);
+    arena = prev;
+  }
+}
+
+static const char **status_texts; // distinct status strings, 0 is ""
+static uint8_t *status_kinds;      // StatusKind each of them decodes to
+static int num_status_texts, status_texts_cap;
+int status_counts[STATUS_COUNT];   // repos shown with each StatusKind
+
+// Decodes status text ("status conclusion") to its StatusKind.
+int status_classify(const char *text) {
+  for (size_t k = 0; k < STATUS_KNOWN; k++) {
+    if (strstr(text, status_map[k].match))
+      return k;
+  }
+  return ST_UNKNOWN;
+}
+
+// Returns the id of status text, adding it if it is new.
+uint16_t status_intern(const char *text) {
+  for (int id = 0; id < num_status_texts; id++) {
+    if (strcmp(status_texts[id], text) == 0)
+      return id;
+  }
+  if (num_status_texts == 0 && text[0])
+    status_intern("");
+  if (num_status_texts == UINT16_MAX)
+    return 0;
+  if (num_status_texts == status_texts_cap) {
+    int cap = status_texts_cap ? status_texts_cap * 2 : 32;
+    const char **grown = realloc(status_texts, cap * sizeof(*grown));
+    if (!grown)
+      return 0;
+    status_texts = grown;
+    uint8_t *kinds = realloc(status_kinds, cap);
+    if (!kinds)
+      return 0;
+    status_kinds = kinds;
+    status_texts_cap = cap;
+  }
+  const char *copy = intern_name(text);
+  if (!copy)
+    return 0;
+  status_texts[num_status_texts] = copy;
+  status_kinds[num_status_texts] = status_classify(text);
+  return num_status_texts++;
+}
+
+const char *status_text(uint16_t id) {
+  return id < num_status_texts ? status_texts[id] : "";
+}
+
+int status_kind(uint16_t id) {
+  return id < num_status_texts ? status_kinds[id] : ST_UNKNOWN;
+}
+
+const char *repo_status(int i) { return status_text(status_id[i]); }
+
+// Returns the kind repo i is shown and counted as.
+int repo_kind(int i) {
+  return status_stale[i] ? ST_STALE : status_kind(status_id[i]);
+}
+
+// Sets repo i's status and stale flag, moving it between status counts.
+void repo_set_status_id(int i, uint16_t id, bool stale) {
+  int severity = status_map[status_kind(status_id[i])].severity;
+  status_counts[repo_kind(i)]--;
+  status_id[i] = id;
+  status_stale[i] = stale;
+  status_counts[repo_kind(i)]++;
+  if (status_map[status_kind(id)].severity != severity)
+    order_reposition(i);
+  if (filter_kind >= 0)
+    filter_dirty = true;
+}
+
+static unsigned hash_name(const char *name) {
+  unsigned h = 2166136261u; // FNV-1a
+  while (*name)
+    h = (h ^ (unsigned char)*name++) * 16777619u;
+  return h;
+}
+
+void repo_index_add(int i) {
+  size_t k = hash_name(REPOS[i]) % repo_nslots;
+  while (repo_slots[k] != 0)
+    k = (k + 1) % repo_nslots;
+  repo_slots[k] = i + 1;
+}
+
+// Returns the index of the repo called name, or -1.
+int repo_lookup(const char *name) {
+  if (repo_nslots == 0)
+    return -1;
+  size_t n = repo_nslots;
+  for (size_t k = hash_name(name) % n; repo_slots[k] != 0; k = (k + 1) % n) {
+    if (strcmp(REPOS[repo_slots[k] - 1], name) == 0)
+      return repo_slots[k] - 1;
+  }
+  return -1;
+}
+
+// Reallocates *arr from old_cap to cap elements of size bytes, zeroing the
+// new ones. Returns false if out of memory, leaving *arr as it was.
+static bool grow_column(void *arr, size_t size, int old_cap, int cap) {
+  char *p = realloc(*(void **)arr, size * cap);
+  if (!p)
+    return false;
+  memset(p + size * old_cap, 0, size * (cap - old_cap));
+  *(void **)arr = p;
+  return true;
+}
+
+// Doubles the capacity of every per-repo array. Returns false if out of
+// memory, in which case the table keeps its current size.
+bool repo_table_grow(void) {
+  int old = repo_cap, cap = repo_cap ? repo_cap * 2 : 256;
+  if (!grow_column(&REPOS, sizeof(*REPOS), old, cap) ||
+      !grow_column(&status_id, sizeof(*status_id), old, cap) ||
+      !grow_column(&fetch_out, sizeof(*fetch_out), old, cap) ||
+      !grow_column(&fetch_out_len, sizeof(*fetch_out_len), old, cap) ||
+      !grow_column(&status_received, sizeof(*status_received), old, cap) ||
+      !grow_column(&status_stale, sizeof(*status_stale), old, cap) ||
+      !grow_column(&repo_dirty, sizeof(*repo_dirty), old, cap) ||
+      !grow_column(&ORIGINAL_INDEX, sizeof(*ORIGINAL_INDEX), old, cap) ||
+      !grow_column(&order, sizeof(*order), old, cap) ||
+      !grow_column(&order_pos, sizeof(*order_pos), old, cap) ||
+      !grow_column(&alpha_order, sizeof(*alpha_order), old, cap) ||
+      !grow_column(&alpha_rank, sizeof(*alpha_rank), old, cap) ||
+      !grow_column(&drawn_repo, sizeof(*drawn_repo), old, cap) ||
+      !grow_column(&pipes, sizeof(*pipes), old, cap) ||
+      !grow_column(&fetch_pids, sizeof(*fetch_pids), old, cap) ||
+      !grow_column(&fetch_queue, sizeof(*fetch_queue), old, cap) ||
+      !grow_column(&fetch_queued, sizeof(*fetch_queued), old, cap) ||
+      !grow_column(&in_flight, sizeof(*in_flight), old, cap) ||
+      !grow_column(&fetch_gen, sizeof(*fetch_gen), old, cap) ||
+      !grow_column(&refresh_owed, sizeof(*refresh_owed), old, cap) ||
+      !grow_column(&sched_heap, sizeof(*sched_heap), old, cap) ||
+      !grow_column(&sched_pos, sizeof(*sched_pos), old, cap) ||
+      !grow_column(&next_due, sizeof(*next_due), old, cap) ||
+      !grow_column(&fetch_mark_us, sizeof(*fetch_mark_us), old, cap) ||
+      !grow_column(&poll_backoff_s, sizeof(*poll_backoff_s), old, cap) ||
+      !grow_column(&repo_etag, sizeof(*repo_etag), old, cap) ||
+      !grow_column(&etag_status, sizeof(*etag_status), old, cap) ||
+      !grow_column(&discovered, sizeof(*discovered), old, cap) ||
+      !grow_column(&run_history, sizeof(*run_history), old, cap) ||
+      !grow_column(&workflow_text, sizeof(*workflow_text), old, cap) ||
+      !grow_column(&default_branch, sizeof(*default_branch), old, cap) ||
+      !grow_column(&pushed_at, sizeof(*pushed_at), old, cap))
+    return false;
+  int *slots = calloc(2 * (size_t)cap, sizeof(*slots));
+  if (!slots)
+    return false;
+
+  for (int i = old; i < cap; i++) {
+    pipes[i][0] = pipes[i][1] = -1;
+    fetch_pids[i] = -1;
+  }
+  // unwrap the part of the fetch queue ring that wrapped past the old end
+  if (fetch_qhead + fetch_qlen > old)
+    memcpy(fetch_queue + old, fetch_queue,
+           (fetch_qhead + fetch_qlen - old) * sizeof(*fetch_queue));
+  repo_cap = cap;
+
+  free(repo_slots);
+  repo_slots = slots;
+  repo_nslots = 2 * (size_t)cap;
+  for (int i = 0; i < NUM_REPOS; i++)
+    repo_index_add(i);
+  return true;
+}
+
+// Appends repo name to the table and name index. Callers check for
+// duplicates. Returns its index, or -1 if out of memory.
+int repo_add(const char *name) {
+  if (NUM_REPOS == repo_cap && !repo_table_grow())
+    return -1;
+  char *copy = intern_name(name);
+  if (!copy)
+    return -1;
+  int i = NUM_REPOS++;
+  REPOS[i] = copy;
+  ORIGINAL_INDEX[i] = i;
+  order[i] = i;
+  order_pos[i] = i;
+  order_dirty = alpha_dirty = true;
+  repo_index_add(i);
+  filter_index_add(i);
+  status_counts[repo_kind(i)]++;
+  return i;
+}
+
+// Drops every repo from index count on, e.g. after a failed listing.
+void repo_truncate(int count) {
+  while (NUM_REPOS > count) {
+    int i = --NUM_REPOS;
+    status_counts[repo_kind(i)]--;
+    status_id[i] = 0;
+    status_stale[i] = false;
+    memset(&run_history[i], 0, sizeof(*run_history));
+    free(workflow_text[i]);
+    workflow_text[i] = NULL;
+    default_branch[i] = 0;
+    pushed_at[i] = 0;
+    refresh_left -= refresh_owed[i];
+    refresh_owed[i] = false;
+  }
+  order_dirty = alpha_dirty = true;
+  filter_index_truncate(count);
+  memset(repo_slots, 0, repo_nslots * sizeof(*repo_slots));
+  for (int i = 0; i < NUM_REPOS; i++)
+    repo_index_add(i);
+}
+
+void repo_table_free(void) {
+  for (int i = 0; i < NUM_REPOS; i++)
+    free(workflow_text[i]);
+  void *columns[] = {REPOS,          status_id,      fetch_out,
+                     fetch_out_len,  status_received, status_stale,
+                     repo_dirty,     ORIGINAL_INDEX, order,
+                     order_pos,      alpha_order,    alpha_rank,
+                     drawn_repo,     pipes,          fetch_pids,
+                     fetch_queue,    fetch_queued,   in_flight,
+                     sched_heap,     sched_pos,      next_due,
+                     fetch_mark_us,  poll_backoff_s, repo_etag,
+                     etag_status,    discovered,     run_history,
+                     workflow_text,  default_branch, repo_slots,
+                     status_texts,   status_kinds,   branch_names,
+                     pushed_at,      fetch_gen,      refresh_owed};
+  for (size_t k = 0; k < sizeof(columns) / sizeof(columns[0]); k++)
+    free(columns[k]);
+  arena_free();
+  filter_free();
+}
+
+// ---- run history ----
+//
+// Each repo keeps its last HISTORY_RUNS workflow runs in a ring of packed
+// bytes, the run's StatusKind and a duration bucket, next to the low 32 bits
+// of each run's id. A repo's first fetch asks for that many runs; later
+// ones ask for the newest HISTORY_PAGE, adding the runs started since and
+// updating those that were still in progress. Fetch results carry the runs
+// after a tab: "status conclusion\tid status conclusion seconds;...".
+
+static int history_kind(uint8_t run) { return run >> 4; }
+static int history_bucket(uint8_t run) { return run & 15; }
+
+// Buckets a run duration: 0 for none, then one per doubling from 1 s.
+int duration_bucket(long seconds) {
+  int bucket = 0;
+  while (seconds > 0 && bucket < 15) {
+    seconds >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+// Returns the number of runs fetching repo i should ask for.
+int history_page(int i) {
+  if (workflow_mode)
+    return WORKFLOW_PAGE;
+  return run_history[i].count ? HISTORY_PAGE : HISTORY_RUNS;
+}
+
+// Records run id in h, adding it if it is newer than any seen or updating
+// it if it is still in the ring. Each run packs its StatusKind in the top 4
+// bits and its duration bucket in the low 4. Run ids are global to GitHub,
+// so runs of one repo can lie far apart, but never 2^32 apart within the
+// ring. Returns true if anything changed.
+static bool history_record(RunHistory *h, uint64_t id, int kind, int bucket) {
+  uint8_t packed = kind << 4 | bucket;
+  if (h->count == 0 || id > h->last_id) {
+    if (h->count == HISTORY_RUNS)
+      h->start = (h->start + 1) % HISTORY_RUNS;
+    else
+      h->count++;
+    int slot = (h->start + h->count - 1) % HISTORY_RUNS;
+    h->runs[slot] = packed;
+    h->ids[slot] = (uint32_t)id;
+    h->last_id = id;
+    return true;
+  }
+  for (int k = h->count - 1; k >= 0; k--) { // newest first
+    int slot = (h->start + k) % HISTORY_RUNS;
+    if (h->ids[slot] == (uint32_t)id) {
+      bool changed = h->runs[slot] != packed;
+      h->runs[slot] = packed;
+      return changed;
+    }
+  }
+  return false;
+}
+
+typedef struct {
+  unsigned long long id, workflow;
+  char text[64]; // "status conclusion"
+  long seconds;
+  char branch[64], name[64];
+} RunEntry;
+
+// Parses the run at p, "id status conclusion seconds workflow branch name"
+// where the last three may be missing, into r. Returns a pointer past it.
+// r->id is 0 if the run is malformed.
+const char *run_next(const char *p, RunEntry *r) {
+  size_t n = strcspn(p, ";");
+  char entry[256], status[32], conclusion[32];
+  snprintf(entry, sizeof(entry), "%.*s", (int)n, p);
+  *r = (RunEntry){0};
+  int name = -1;
+  if (sscanf(entry, "%llu %31s %31s %ld %llu %63s %n", &r->id, status,
+             conclusion, &r->seconds, &r->workflow, r->branch, &name) < 4)
+    r->id = 0;
+  snprintf(r->text, sizeof(r->text), "%s %s", status, conclusion);
+  if (name >= 0)
+    snprintf(r->name, sizeof(r->name), "%s", entry + name);
+  return p[n] ? p + n + 1 : p + n;
+}
+
+// Applies the runs of a fetch result, newest first, to repo i. Returns true
+// if its history changed.
+bool history_apply(int i, const char *runs) {
+  uint64_t ids[HISTORY_RUNS];
+  int kinds[HISTORY_RUNS], buckets[HISTORY_RUNS], n = 0;
+  for (const char *p = runs; *p && n < HISTORY_RUNS;) {
+    RunEntry r;
+    p = run_next(p, &r);
+    if (r.id) {
+      ids[n] = r.id;
+      kinds[n] = status_classify(r.text);
+      buckets[n++] = duration_bucket(r.seconds);
+    }
+  }
+  bool changed = false;
+  while (n-- > 0) // oldest first, so new runs append in order
+    changed |= history_record(&run_history[i], ids[n], kinds[n], buckets[n]);
+  return changed;
+}
+
+// Fills glyphs with a sparkline of up to max of repo i's latest runs, oldest
+// first, one block per run whose height is its duration, and kinds with
+// each run's StatusKind. Returns the number of runs.
+int history_sparkline(int i, wchar_t *glyphs, int *kinds, int max) {
+  static const wchar_t blocks[] = L"▁▂▃▄▅▆▇█";
+  const RunHistory *h = &run_history[i];
+  int n = h->count < max ? h->count : max;
+  int from = h->count - n, low = 15, high = 0;
+  for (int k = from; k < h->count; k++) {
+    int b = history_bucket(h->runs[(h->start + k) % HISTORY_RUNS]);
+    low = b < low ? b : low;
+    high = b > high ? b : high;
+  }
+  for (int k = 0; k < n; k++) {
+    uint8_t run = h->runs[(h->start + from + k) % HISTORY_RUNS];
+    int b = history_bucket(run);
+    glyphs[k] = blocks[high > low ? (b - low) * 7 / (high - low) : 0];
+    kinds[k] = history_kind(run);
+  }
+  glyphs[n] = L'\0';
+  return n;
+}
+
+// Returns the color pair a sparkline draws a run of kind in.
+static int history_color(int kind) {
+  switch (kind) {
+  case ST_SUCCESS:
+    return 8;
+  case ST_FAILURE:
+  case ST_TIMED_OUT:
+  case ST_ACTION_REQUIRED:
+    return 9;
+  case ST_IN_PROGRESS:
+  case ST_QUEUED:
+    return 10;
+  default:
+    return 0;
+  }
+}
+
+// Draws the sparkline of up to max of repo i's latest runs at y, x, each run
+// colored by how it went. Returns the columns drawn.
+int draw_sparkline(int y, int x, int i, int max) {
+  wchar_t glyphs[HISTORY_RUNS + 1];
+  int kinds[HISTORY_RUNS];
+  if (max > HISTORY_RUNS)
+    max = HISTORY_RUNS;
+  if (max <= 0)
+    return 0;
+  int n = history_sparkline(i, glyphs, kinds, max);
+  for (int k = 0; k < n; k++) {
+    int pair = history_color(kinds[k]);
+    attron(COLOR_PAIR(pair));
+    mvprintw(y, x + k, "%lc", glyphs[k]);
+    attroff(COLOR_PAIR(pair));
+  }
+  return n;
+}
+
+// ---- per-workflow status ----
+//
+// A repo's latest run may belong to any workflow, so a green docs build can
+// hide a red one on main. With --workflows each fetch asks for a page of
+// recent runs, still one request, and keeps the latest run of each workflow,
+// or of each workflow and branch once --branch or --default-branch narrows
+// the runs. The cell shows the most urgent of them, the hover all of them.
+
+static const char *branch_list; // comma separated branches to keep, or NULL
+static bool branch_default;      // keep each repo's default branch too
+
+// Returns the id of branch name, adding it if it is new, or 0 if out of
+// memory.
+uint16_t branch_intern(const char *name) {
+  for (int id = 1; id < num_branch_names; id++) {
+    if (strcmp(branch_names[id], name) == 0)
+      return id;
+  }
+  if (num_branch_names == UINT16_MAX)
+    return 0;
+  if (num_branch_names == branch_names_cap) {
+    int cap = branch_names_cap ? branch_names_cap * 2 : 16;
+    char **grown = realloc(branch_names, cap * sizeof(*grown));
+    if (!grown)
+      return 0;
+    branch_names = grown;
+    branch_names_cap = cap;
+  }
+  if (num_branch_names == 0)
+    branch_names[num_branch_names++] = "";
+  char *copy = intern_name(name);
+  if (!copy)
+    return 0;
+  branch_names[num_branch_names] = copy;
+  return num_branch_names++;
+}
+
+// Returns true if runs of repo i on branch count.
+static bool branch_wanted(int i, const char *branch) {
+  if (!branch_list && !branch_default)
+    return true;
+  if (branch_default) {
+    if (!default_branch[i])
+      return true; // not listed yet, so any branch may be it
+    if (strcmp(branch_names[default_branch[i]], branch) == 0)
+      return true;
+  }
+  size_t len = strlen(branch);
+  for (const char *p = branch_list; p && *p;) {
+    size_t n = strcspn(p, ",");
+    if (n == len && strncmp(p, branch, n) == 0)
+      return true;
+    p += n;
+    if (*p)
+      p++;
+  }
+  return false;
+}
+
+// Reduces the runs of a fetch result, newest first, to the latest run of
+// each workflow on a wanted branch, storing them in workflow_text[i] as
+// "status conclusion<TAB>workflow" lines and the most urgent status in
+// status. Returns true if the list changed.
+bool workflow_reduce(int i, const char *runs, char *status, size_t len) {
+  bool by_branch = branch_list || branch_default;
+  unsigned long long seen[WORKFLOWS_MAX];
+  char seen_branch[WORKFLOWS_MAX][64];
+  int nseen = 0, worst = INT_MAX;
+  char text[WORKFLOWS_MAX * 96] = "";
+  size_t used = 0;
+  snprintf(status, len, "no_runs");
+  for (const char *p = runs; *p && nseen < WORKFLOWS_MAX;) {
+    RunEntry r;
+    p = run_next(p, &r);
+    if (!r.id || !branch_wanted(i, r.branch))
+      continue;
+    int k = 0;
+    while (k < nseen && (seen[k] != r.workflow ||
+                         (by_branch && strcmp(seen_branch[k], r.branch) != 0)))
+      k++;
+    if (k < nseen)
+      continue; // an older run of a workflow already listed
+    seen[nseen] = r.workflow;
+    snprintf(seen_branch[nseen++], sizeof(seen_branch[0]), "%s", r.branch);
+    int severity = status_map[status_classify(r.text)].severity;
+    if (severity < worst) {
+      worst = severity;
+      snprintf(status, len, "%s", r.text);
+    }
+    int n = snprintf(text + used, sizeof(text) - used, "%s\t%s%s%s%s\n",
+                     r.text, r.name[0] ? r.name : "workflow",
+                     by_branch ? " (" : "", by_branch ? r.branch : "",
+                     by_branch ? ")" : "");
+    if (n > 0 && used + n < sizeof(text))
+      used += n;
+    else
+      text[used] = '\0';
+  }
+  if (workflow_text[i] && strcmp(workflow_text[i], text) == 0)
+    return false;
+  char *copy = strdup(text);
+  if (!copy)
+    return false;
+  free(workflow_text[i]);
+  workflow_text[i] = copy;
+  return true;
+}
+
+// Writes repo i's workflows to buf as "icon name" pairs, most recent first.
+void workflow_describe(int i, char *buf, size_t len) {
+  size_t used = 0;
+  buf[0] = '\0';
+  for (const char *p = workflow_text[i]; p && *p && used + 1 < len;) {
+    size_t n = strcspn(p, "\n"), tab = strcspn(p, "\t");
+    char run[64];
+    snprintf(run, sizeof(run), "%.*s", (int)(tab < n ? tab : n), p);
+    int w = snprintf(buf + used, len - used, "%s%ls %.*s", used ? "  " : "",
+                     status_map[status_classify(run)].icon,
+                     tab < n ? (int)(n - tab - 1) : 0, p + tab + 1);
+    if (w < 0)
+      break;
+    used += w;
+    p += p[n] ? n + 1 : n;
+  }
+  if (used >= len)
+    buf[len - 1] = '\0';
+}
+
+// ---- telemetry ----
+//
+// Latencies go into log-linear histograms: exact below 8 us, then 8 buckets
+// per power of two, so percentiles are within 12.5% at any scale.
+
+#define HIST_SUB 8
+#define HIST_BUCKETS (40 * HIST_SUB)
+#define TELEMETRY_INTERVAL_S 10 // between lines of --telemetry output
+#define RATE_WINDOW_S 5          // fetch throughput is averaged over this
+
+typedef struct {
+  const char *name;
+  uint32_t counts[HIST_BUCKETS];
+  uint64_t count, max;
+} Histogram;
+
+enum { HIST_FETCH, HIST_QUEUE, HIST_FRAME, HIST_SORT, HIST_COUNT };
+
+static Histogram hists[HIST_COUNT] = {
+    [HIST_FETCH] = {.name = "fetch"},  // dispatch to result
+    [HIST_QUEUE] = {.name = "queue"},  // queued to dispatched
+    [HIST_FRAME] = {.name = "frame"},  // one pass of drawing
+    [HIST_SORT] = {.name = "sort"},    // apply_sort()
+};
+static uint32_t fetch_done[RATE_WINDOW_S + 1]; // results per second, a ring
+static time_t fetch_done_at[RATE_WINDOW_S + 1];
+static FILE *telemetry_file; // --telemetry output, NULL if off
+static long long telemetry_next_ms;
+
+static int hist_bucket(uint64_t v) {
+  if (v < HIST_SUB)
+    return (int)v;
+  int e = 63 - __builtin_clzll(v); // at least 3
+  int b = (e - 2) * HIST_SUB + (int)((v >> (e - 3)) & (HIST_SUB - 1));
+  return b < HIST_BUCKETS ? b : HIST_BUCKETS - 1;
+}
+
+// Returns the smallest value that lands in bucket b.
+static uint64_t hist_floor(int b) {
+  if (b < HIST_SUB)
+    return b;
+  int e = b / HIST_SUB + 2;
+  return (uint64_t)(HIST_SUB + b % HIST_SUB) << (e - 3);
+}
+
+void hist_record(Histogram *h, long long us) {
+  uint64_t v = us > 0 ? (uint64_t)us : 0;
+  h->counts[hist_bucket(v)]++;
+  h->count++;
+  if (v > h->max)
+    h->max = v;
+}
+
+// Returns the value at percentile p (0-100), 0 if nothing was recorded.
+uint64_t hist_percentile(const Histogram *h, double p) {
+  uint64_t rank = (uint64_t)(h->count * p / 100.0 + 0.5), seen = 0;
+  if (rank < 1)
+    rank = 1;
+  for (int b = 0; b < HIST_BUCKETS && h->count; b++) {
+    seen += h->counts[b];
+    if (seen >= rank)
+      return hist_floor(b) < h->max ? hist_floor(b) : h->max;
+  }
+  return h->max;
+}
+
+// Counts a finished fetch towards the throughput figure.
+void telemetry_fetch_done(void) {
+  time_t now = time(NULL);
+  int slot = now % (RATE_WINDOW_S + 1);
+  if (fetch_done_at[slot] != now) {
+    fetch_done_at[slot] = now;
+    fetch_done[slot] = 0;
+  }
+  fetch_done[slot]++;
+}
+
+// Returns fetch results per second over the last few whole seconds.
+double telemetry_fetch_rate(void) {
+  time_t now = time(NULL);
+  uint32_t done = 0;
+  for (int k = 0; k <= RATE_WINDOW_S; k++) {
+    if (fetch_done_at[k] < now && now - fetch_done_at[k] <= RATE_WINDOW_S)
+      done += fetch_done[k];
+  }
+  return (double)done / RATE_WINDOW_S;
+}
+
+// Formats histogram h as a JSON object of millisecond percentiles.
+int hist_json(const Histogram *h, char *buf, size_t len) {
+  return snprintf(buf, len,
+                  "\"%s_ms\":{\"p50\":%.3f,\"p95\":%.3f,\"p99\":%.3f,"
+                  "\"max\":%.3f,\"count\":%llu}",
+                  h->name, hist_percentile(h, 50) / 1000.0,
+                  hist_percentile(h, 95) / 1000.0,
+                  hist_percentile(h, 99) / 1000.0, h->max / 1000.0,
+                  (unsigned long long)h->count);
+}
+
+// Formats one JSON line of every histogram plus the fetch gauges.
+int telemetry_line(char *buf, size_t len) {
+  int queued = fetch_qlen, running = fetches_busy() - fetch_qlen;
+  int n = snprintf(buf, len,
+                   "{\"ts\":%lld,\"in_flight\":%d,\"queued\":%d,"
+                   "\"fetches_per_s\":%.1f",
+                   (long long)time(NULL), running, queued,
+                   telemetry_fetch_rate());
+  for (int h = 0; h < HIST_COUNT && n > 0 && (size_t)n < len; h++) {
+    buf[n++] = ',';
+    n += hist_json(&hists[h], buf + n, len - n);
+  }
+  if (n > 0 && (size_t)n + 2 < len) {
+    buf[n++] = '}';
+    buf[n++] = '\n';
+    buf[n] = '\0';
+  }
+  return n;
+}
+
+// Appends a line to the --telemetry file when one is due. Returns the ms
+// timestamp of the next one, or -1 without a file.
+long long telemetry_dump(void) {
+  if (!telemetry_file)
+    return -1;
+  long long now = now_ms();
+  if (now >= telemetry_next_ms) {
+    char line[1024];
+    telemetry_line(line, sizeof(line));
+    fputs(line, telemetry_file);
+    fflush(telemetry_file);
+    telemetry_next_ms = now + TELEMETRY_INTERVAL_S * 1000LL;
+  }
+  return telemetry_next_ms;
+}
+
+// Writes a last line and closes the --telemetry file.
+void telemetry_close(void) {
+  if (!telemetry_file)
+    return;
+  telemetry_next_ms = 0;
+  telemetry_dump();
+  fclose(telemetry_file);
+  telemetry_file = NULL;
+}
+
+// Draws the overlay toggled with 't' in the top right corner.
+void draw_telemetry(int term_cols) {
+  int width = 48, col = term_cols > width ? term_cols - width : 0;
+  char line[HIST_COUNT + 2][64];
+  snprintf(line[0], sizeof(line[0]), " %-6s%8s %8s %8s %8s", "ms", "p50",
+           "p95", "p99", "max");
+  for (int h = 0; h < HIST_COUNT; h++) {
+    const Histogram *hist = &hists[h];
+    snprintf(line[h + 1], sizeof(line[h + 1]), " %-6s%8.1f %8.1f %8.1f %8.1f",
+             hist->name, hist_percentile(hist, 50) / 1000.0,
+             hist_percentile(hist, 95) / 1000.0,
+             hist_percentile(hist, 99) / 1000.0, hist->max / 1000.0);
+  }
+  int queued = fetch_qlen;
+  snprintf(line[HIST_COUNT + 1], sizeof(line[0]),
+           " in flight %d  queued %d  %.1f fetches/s", fetches_busy() - queued,
+           queued, telemetry_fetch_rate());
+  attron(A_REVERSE);
+  for (int k = 0; k < HIST_COUNT + 2; k++)
+    mvprintw(1 + k, col, "%-*.*s", width, width, line[k]);
+  attroff(A_REVERSE);
+}
+
+// ---- display order ----
+
+int cmp_alpha(const void *a, const void *b) {
+  int i = *(const int *)a;
+  int j = *(const int *)b;
+  return strcmp(REPOS[i], REPOS[j]);
+}
+
+static int repo_severity(int i) {
+  return status_map[status_kind(status_id[i])].severity;
+}
+
+// Status sort order: most severe first, then by name.
+static bool order_before(int i, int j) {
+  int c = repo_severity(i) - repo_severity(j);
+  return c != 0 ? c < 0 : alpha_rank[i] < alpha_rank[j];
+}
+
+// Sorts the repos by name into alpha_order and alpha_rank if new repos have
+// arrived since the last time.
+void alpha_rebuild(void) {
+  if (!alpha_dirty)
+    return;
+  for (int i = 0; i < NUM_REPOS; i++)
+    alpha_order[i] = i;
+  qsort(alpha_order, NUM_REPOS, sizeof(int), cmp_alpha);
+  for (int k = 0; k < NUM_REPOS; k++)
+    alpha_rank[alpha_order[k]] = k;
+  alpha_dirty = false;
+}
+
+// Rebuilds order for the current sort mode. Names are sorted only when repos
+// were added; the status order is a stable bucket pass over them.
+void apply_sort(void) {
+  long long started = now_us();
+  if (sort_mode != SORT_DEFAULT)
+    alpha_rebuild();
+  if (sort_mode == SORT_ALPHA) {
+    memcpy(order, alpha_order, NUM_REPOS * sizeof(int));
+  } else if (sort_mode == SORT_STATUS) {
+    int start[STATUS_COUNT + 1] = {0};
+    for (int i = 0; i < NUM_REPOS; i++)
+      start[repo_severity(i) + 1]++;
+    for (size_t s = 1; s <= STATUS_COUNT; s++)
+      start[s] += start[s - 1];
+    for (int k = 0; k < NUM_REPOS; k++) {
+      int i = alpha_order[k];
+      order[start[repo_severity(i)]++] = i;
+    }
+  } else {
+    memcpy(order, ORIGINAL_INDEX, NUM_REPOS * sizeof(int));
+  }
+  for (int k = 0; k < NUM_REPOS; k++)
+    order_pos[order[k]] = k;
+  order_dirty = false;
+  filter_dirty = true;
+  hist_record(&hists[HIST_SORT], now_us() - started);
+}
+
+// Moves repo i to its place in the status order after its severity changed,
+// finding the slot by binary search and shifting only the repos in between.
+void order_reposition(int i) {
+  if (sort_mode != SORT_STATUS || order_dirty)
+    return;
+  int pos = order_pos[i], to = pos;
+  if (pos > 0 && order_before(i, order[pos - 1])) {
+    int lo = 0, hi = pos - 1; // first repo i now sorts before
+    while (lo < hi) {
+      int mid = lo + (hi - lo) / 2;
+      if (order_before(i, order[mid]))
+        hi = mid;
+      else
+        lo = mid + 1;
+    }
+    for (to = lo; pos > to; pos--) {
+      order[pos] = order[pos - 1];
+      order_pos[order[pos]] = pos;
+    }
+  } else if (pos + 1 < NUM_REPOS && order_before(order[pos + 1], i)) {
+    int lo = pos + 1, hi = NUM_REPOS; // first repo not sorting before i
+    while (lo < hi) {
+      int mid = lo + (hi - lo) / 2;
+      if (order_before(order[mid], i))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    for (to = lo - 1; pos < to; pos++) {
+      order[pos] = order[pos + 1];
+      order_pos[order[pos]] = pos;
+    }
+  }
+  order[to] = i;
+  order_pos[i] = to;
+  filter_dirty = true;
+}
+
+// ---- name filter ----
+//
+// `/` narrows the grid to repos whose name contains the typed text, ignoring
+// case, and optionally to one status. As repos are added their lowercase
+// names are copied back to back into one pool and indexed: each character
+// and pair of characters with the repos containing it, each trigram with the
+// repo and offset of every occurrence. A query of one or two characters is
+// answered straight from its list; a longer one checks only the occurrences
+// of its rarest trigram. Each prefix of the query keeps its matches, so
+// backspace costs nothing.
+
+#define FILTER_MAX 64 // longest query
+
+typedef struct {
+  uint32_t key; // length << 24 | bytes, 0 for an empty slot
+  uint32_t *at; // repo << 8 | offset of each occurrence, ascending; the
+                // offset is 0 and repos appear once below three bytes
+  int len, cap;
+} Gram;
+
+static Gram *grams;
+static size_t gram_cap, gram_count;
+static char *name_pool; // lowercase names, each followed by a NUL
+static size_t name_pool_len, name_pool_cap;
+static uint32_t *name_off; // where each indexed repo's name starts, + end
+static int names_indexed, name_off_cap;
+
+char filter_text[FILTER_MAX + 1]; // the query as typed, "" for none
+static char filter_lower[FILTER_MAX + 1];
+int filter_len;
+static int *filter_level[FILTER_MAX + 1]; // matches of each query prefix
+static int filter_level_len[FILTER_MAX + 1], filter_level_cap[FILTER_MAX + 1];
+int *filter_view; // repos shown while filtering, in display order
+int filter_view_len;
+static uint64_t *filter_bits; // repos matching the query, while building
+static int filter_view_cap;
+
+static bool grow_array(void **items, int *cap, int need, size_t size) {
+  if (need <= *cap)
+    return true;
+  int grown_cap = *cap ? *cap * 2 : 16;
+  while (grown_cap < need)
+    grown_cap *= 2;
+  void *grown = realloc(*items, grown_cap * size);
+  if (!grown)
+    return false;
+  *items = grown;
+  *cap = grown_cap;
+  return true;
+}
+
+static uint32_t gram_key(const char *s, int n) {
+  uint32_t key = n;
+  for (int k = 0; k < 3; k++)
+    key = key << 8 | (k < n ? (unsigned char)s[k] : 0);
+  return key;
+}
+
+// Returns the occurrences of the n-byte gram at s, adding an empty list if
+// create is set, or NULL.
+static Gram *gram_find(const char *s, int n, bool create) {
+  if (create && (gram_count + 1) * 2 > gram_cap) {
+    size_t cap = gram_cap ? gram_cap * 2 : 4096;
+    Gram *grown = calloc(cap, sizeof(*grown));
+    if (!grown)
+      return NULL;
+    for (size_t k = 0; k < gram_cap; k++) {
+      if (!grams[k].key)
+        continue;
+      size_t slot = grams[k].key * 2654435761u & (cap - 1);
+      while (grown[slot].key)
+        slot = (slot + 1) & (cap - 1);
+      grown[slot] = grams[k];
+    }
+    free(grams);
+    grams = grown;
+    gram_cap = cap;
+  }
+  if (!gram_cap)
+    return NULL;
+  uint32_t key = gram_key(s, n);
+  size_t slot = key * 2654435761u & (gram_cap - 1);
+  while (grams[slot].key && grams[slot].key != key)
+    slot = (slot + 1) & (gram_cap - 1);
+  if (!grams[slot].key) {
+    if (!create)
+      return NULL;
+    grams[slot].key = key;
+    gram_count++;
+  }
+  return &grams[slot];
+}
+
+// Records that repo i has the n-byte gram at s at offset off.
+static void gram_add(const char *s, int n, int i, size_t off) {
+  Gram *g = gram_find(s, n, true);
+  if (!g || (n < 3 && g->len > 0 && (int)(g->at[g->len - 1] >> 8) == i))
+    return;
+  if (grow_array((void **)&g->at, &g->cap, g->len + 1, sizeof(*g->at)))
+    g->at[g->len++] = (uint32_t)i << 8 | (n < 3 ? 0 : off);
+}
+
+static void level_push(int n, int i) {
+  if (grow_array((void **)&filter_level[n], &filter_level_cap[n],
+                 filter_level_len[n] + 1, sizeof(int)))
+    filter_level[n][filter_level_len[n]++] = i;
+}
+
+// Indexes repo i, just added, and adds it to the current matches.
+void filter_index_add(int i) {
+  if (i != names_indexed)
+    return; // repos are added in index order
+  size_t len = strlen(REPOS[i]);
+  if (name_pool_len + len + 1 > name_pool_cap) {
+    size_t cap = name_pool_cap ? name_pool_cap * 2 : 65536;
+    while (cap < name_pool_len + len + 1)
+      cap *= 2;
+    char *grown = realloc(name_pool, cap);
+    if (!grown)
+      return;
+    name_pool = grown;
+    name_pool_cap = cap;
+  }
+  if (!grow_array((void **)&name_off, &name_off_cap, i + 2, sizeof(uint32_t)))
+    return;
+  char *name = name_pool + name_pool_len;
+  for (size_t k = 0; k <= len; k++)
+    name[k] = tolower((unsigned char)REPOS[i][k]);
+  name_off[i] = name_pool_len;
+  name_pool_len += len + 1;
+  name_off[i + 1] = name_pool_len;
+  names_indexed = i + 1;
+
+  // offsets past 255 are not indexed; GitHub names stay within 140
+  for (size_t k = 0; k < len && k < 256; k++) {
+    for (int n = 1; n <= 3 && k + n <= len; n++)
+      gram_add(name + k, n, i, k);
+  }
+  for (int n = 1; n <= filter_len; n++) {
+    if (memmem(name, len, filter_lower, n))
+      level_push(n, i);
+  }
+  filter_dirty = true;
+}
+
+// Drops repos from index count on.
+void filter_index_truncate(int count) {
+  if (count >= names_indexed)
+    return;
+  for (size_t k = 0; k < gram_cap; k++) {
+    Gram *g = &grams[k];
+    while (g->len > 0 && (int)(g->at[g->len - 1] >> 8) >= count)
+      g->len--;
+  }
+  name_pool_len = name_off[count];
+  names_indexed = count;
+  for (int n = 1; n <= filter_len; n++) {
+    int kept = 0;
+    for (int k = 0; k < filter_level_len[n]; k++) {
+      if (filter_level[n][k] < count)
+        filter_level[n][kept++] = filter_level[n][k];
+    }
+    filter_level_len[n] = kept;
+  }
+  filter_dirty = true;
+}
+
+bool filter_active(void) {
+  return filter_len > 0 || filter_kind >= 0;
+}
+
+// Appends c to the query and finds the repos matching it.
+void filter_push(char c) {
+  if (filter_len == FILTER_MAX || c == '\0')
+    return;
+  filter_text[filter_len] = c;
+  filter_lower[filter_len] = tolower((unsigned char)c);
+  int n = ++filter_len;
+  filter_text[n] = filter_lower[n] = '\0';
+  filter_level_len[n] = 0;
+  filter_dirty = true;
+
+  if (n < 3) {
+    Gram *g = gram_find(filter_lower, n, false);
+    if (!g || !grow_array((void **)&filter_level[n], &filter_level_cap[n],
+                          g->len, sizeof(int)))
+      return;
+    for (int k = 0; k < g->len; k++)
+      filter_level[n][k] = g->at[k] >> 8;
+    filter_level_len[n] = g->len;
+    return;
+  }
+
+  // the rarest trigram's occurrences, each checked where the query would
+  // start
+  Gram *rarest = NULL;
+  int rarest_at = 0;
+  for (int k = 0; k + 3 <= n; k++) {
+    Gram *g = gram_find(filter_lower + k, 3, false);
+    if (!g || g->len == 0)
+      return; // nothing contains it
+    if (!rarest || g->len < rarest->len) {
+      rarest = g;
+      rarest_at = k;
+    }
+  }
+  int last = -1;
+  for (int k = 0; k < rarest->len; k++) {
+    int i = rarest->at[k] >> 8;
+    long start = (long)(rarest->at[k] & 255) - rarest_at;
+    long len = name_off[i + 1] - name_off[i] - 1;
+    bool match = n == 3; // the trigram is the whole query
+    if (!match && i != last && start >= 0 && start + n <= len)
+      match = memcmp(name_pool + name_off[i] + start, filter_lower, n) == 0;
+    if (match && i != last) {
+      level_push(n, i);
+      last = i;
+    }
+  }
+}
+
+// Drops the last character of the query; the shorter query's matches are
+// still current.
+void filter_pop(void) {
+  if (filter_len > 0) {
+    filter_len--;
+    filter_text[filter_len] = filter_lower[filter_len] = '\0';
+  }
+  filter_dirty = true;
+}
+
+void filter_clear(void) {
+  filter_len = 0;
+  filter_text[0] = filter_lower[0] = '\0';
+  filter_kind = -1;
+  filter_dirty = true;
+}
+
+static int cmp_order_pos(const void *a, const void *b) {
+  return order_pos[*(const int *)a] - order_pos[*(const int *)b];
+}
+
+// Rebuilds filter_view from the current matches in display order. Matches
+// are kept in repo order, which is the default display order; otherwise a
+// few are sorted, and many are picked out of order[] in one pass.
+void filter_update(void) {
+  filter_dirty = false;
+  if (!filter_active())
+    return;
+  if (filter_view_cap < repo_cap) {
+    uint64_t *bits = calloc((repo_cap + 63) / 64, sizeof(*bits));
+    int *view = malloc(repo_cap * sizeof(*view));
+    if (!bits || !view) {
+      free(bits);
+      free(view);
+      return;
+    }
+    free(filter_bits);
+    free(filter_view);
+    filter_bits = bits;
+    filter_view = view;
+    filter_view_cap = repo_cap;
+  }
+  bool by_kind = filter_kind >= 0;
+  filter_view_len = 0;
+  if (filter_len == 0) {
+    for (int k = 0; k < NUM_REPOS; k++) {
+      if ((int)repo_kind(order[k]) == filter_kind)
+        filter_view[filter_view_len++] = order[k];
+    }
+    return;
+  }
+  const int *matches = filter_level[filter_len];
+  int count = filter_level_len[filter_len], log2 = 1;
+  while (1 << log2 < count)
+    log2++;
+  if (sort_mode == SORT_DEFAULT || (long long)count * log2 < NUM_REPOS) {
+    for (int k = 0; k < count; k++) {
+      if (!by_kind || (int)repo_kind(matches[k]) == filter_kind)
+        filter_view[filter_view_len++] = matches[k];
+    }
+    if (sort_mode != SORT_DEFAULT)
+      qsort(filter_view, filter_view_len, sizeof(int), cmp_order_pos);
+    return;
+  }
+  for (int k = 0; k < count; k++)
+    filter_bits[matches[k] / 64] |= 1ull << (matches[k] % 64);
+  for (int k = 0; k < NUM_REPOS; k++) {
+    int i = order[k];
+    if (filter_bits[i / 64] >> (i % 64) & 1 &&
+        (!by_kind || (int)repo_kind(i) == filter_kind))
+      filter_view[filter_view_len++] = i;
+  }
+  for (int k = 0; k < count; k++)
+    filter_bits[matches[k] / 64] = 0;
+}
+
+// Returns how many repos the grid shows.
+int grid_count(void) {
+  return filter_active() ? filter_view_len : NUM_REPOS;
+}
+
+// Returns the repo at grid position k.
+int grid_repo(int k) {
+  return filter_active() ? filter_view[k] : order[k];
+}
+
+void filter_free(void) {
+  for (size_t k = 0; k < gram_cap; k++)
+    free(grams[k].at);
+  free(grams);
+  grams = NULL;
+  gram_cap = gram_count = 0;
+  free(name_pool);
+  free(name_off);
+  name_pool = NULL;
+  name_off = NULL;
+  name_pool_len = name_pool_cap = 0;
+  names_indexed = name_off_cap = 0;
+  for (int n = 0; n <= FILTER_MAX; n++) {
+    free(filter_level[n]);
+    filter_level[n] = NULL;
+    filter_level_len[n] = filter_level_cap[n] = 0;
+  }
+  free(filter_bits);
+  free(filter_view);
+  filter_bits = NULL;
+  filter_view = NULL;
+  filter_view_cap = filter_view_len = 0;
+}
+
+// ---- event loop registration ----
+
+// What a watched fd belongs to; stored in its epoll data next to an index.
+typedef enum {
+  WATCH_INPUT,
+  WATCH_SIGNAL,
+  WATCH_TIMER,
+  WATCH_GH,
+  WATCH_ENGINE,
+  WATCH_DISCOVERY,
+  WATCH_LISTEN, // daemon socket
+  WATCH_CLIENT, // client attached to the daemon
+  WATCH_DAEMON, // the daemon, seen from an attached client
+  WATCH_HOOK_LISTEN,
+  WATCH_HOOK,   // webhook delivery being read
+  WATCH_CHILD,  // pidfd of a child that closed its output before exiting
+  WATCH_LISTING // pidfd of a repo listing, likewise
+} WatchKind;
+
+static int loop_fd = -1; // epoll instance every fd is registered with
+
+// Registers fd with the event loop, or updates its events, tagged with kind
+// and index.
+void watch_fd(int fd, uint32_t events, WatchKind kind, int index) {
+  if (loop_fd == -1 || fd == -1)
+    return;
+  struct epoll_event ev = {.events = events};
+  ev.data.u64 = (uint64_t)kind << 32 | (uint32_t)index;
+  if (epoll_ctl(loop_fd, EPOLL_CTL_MOD, fd, &ev) == -1 && errno == ENOENT)
+    epoll_ctl(loop_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+// Removes fd from the event loop ahead of closing it.
+void unwatch_fd(int fd) {
+  if (loop_fd != -1 && fd != -1)
+    epoll_ctl(loop_fd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+// Arms timerfd fd to fire once at the monotonic time at_ms, or disarms it if
+// at_ms is negative. *armed remembers the deadline so unchanged ones cost
+// nothing.
+void timer_arm(int fd, long long *armed, long long at_ms) {
+  if (*armed == at_ms)
+    return;
+  *armed = at_ms;
+  struct itimerspec its = {0};
+  if (at_ms >= 0) {
+    its.it_value.tv_sec = at_ms / 1000;
+    its.it_value.tv_nsec = (at_ms % 1000) * 1000000L;
+  }
+  timerfd_settime(fd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+// Routes SIGINT, SIGTERM and SIGWINCH through a signalfd watched by the event
+// loop. Returns the signalfd. Children are reaped through their pidfds.
+int signals_watch(void) {
+  sigset_t sigs;
+  sigemptyset(&sigs);
+  sigaddset(&sigs, SIGINT);
+  sigaddset(&sigs, SIGTERM);
+  sigaddset(&sigs, SIGWINCH);
+  sigprocmask(SIG_BLOCK, &sigs, NULL);
+  signal(SIGPIPE, SIG_IGN); // dropped keep-alive connections
+  int sig_fd = signalfd(-1, &sigs, SFD_NONBLOCK | SFD_CLOEXEC);
+  watch_fd(sig_fd, EPOLLIN, WATCH_SIGNAL, 0);
+  return sig_fd;
+}
+
+static int devnull_fd = -1; // children's stderr, opened once
+
+// Starts argv with stdout on a fresh pipe and stderr silenced, storing the
+// pipe's read end in *out. If in is not NULL the child's stdin is also a
+// pipe whose write end is stored there. Returns the child's pid, or -1.
+// posix_spawn clones without copying the page tables, which fork() would do
+// for the whole screen and repo table on every fetch.
+pid_t spawn_piped(char *const argv[], int *in, int *out) {
+  int fds[2], ins[2] = {-1, -1};
+  if (devnull_fd == -1)
+    devnull_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+  if (pipe2(fds, O_CLOEXEC) == -1)
+    return -1;
+  if (in && pipe2(ins, O_CLOEXEC) == -1) {
+    close(fds[0]);
+    close(fds[1]);
+    return -1;
+  }
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+  if (in)
+    posix_spawn_file_actions_adddup2(&actions, ins[0], STDIN_FILENO);
+  if (devnull_fd != -1)
+    posix_spawn_file_actions_adddup2(&actions, devnull_fd, STDERR_FILENO);
+
+  posix_spawnattr_t attr;
+  sigset_t none, pipe_default; // the UI blocks signals for its signalfd
+  sigemptyset(&none);
+  sigemptyset(&pipe_default);
+  sigaddset(&pipe_default, SIGPIPE);
+  posix_spawnattr_init(&attr);
+  posix_spawnattr_setsigmask(&attr, &none);
+  posix_spawnattr_setsigdefault(&attr, &pipe_default);
+  posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK |
+                                      POSIX_SPAWN_SETSIGDEF |
+                                      POSIX_SPAWN_USEVFORK);
+
+  pid_t pid;
+  int err = posix_spawnp(&pid, argv[0], &actions, &attr, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  posix_spawnattr_destroy(&attr);
+  close(fds[1]);
+  if (in)
+    close(ins[0]);
+  if (err != 0) {
+    close(fds[0]);
+    if (in)
+      close(ins[1]);
+    fprintf(stderr, "Failed to execute '%s'. GitHub CLI is required.\n",
+            argv[0]);
+    return -1;
+  }
+  *out = fds[0];
+  if (in)
+    *in = ins[1];
+  return pid;
+}
+
+pid_t spawn_reader(char *const argv[], int *out) {
+  return spawn_piped(argv, NULL, out);
+}
+
+// Watches child pid's pidfd as kind/index so the event loop hears when it
+// exits. Returns the pidfd, or -1 if the kernel has none; callers then wait
+// for the child, which closed its output and is about to exit anyway.
+int child_watch(pid_t pid, WatchKind kind, int index) {
+  int fd = pidfd_open(pid, 0);
+  if (fd != -1)
+    watch_fd(fd, EPOLLIN, kind, index);
+  return fd;
+}
+
+typedef struct {
+  pid_t pid;
+  int pidfd; // readable once the child has exited
+} Exiting;
+
+static Exiting *exiting; // finished children that had not exited yet
+static int exiting_count, exiting_cap;
+
+// Reaps child pid if it has exited, or watches its pidfd so reap_io() can
+// when it does; the caller never blocks on a child that is still shutting
+// down.
+void reap_child(pid_t pid) {
+  if (pid <= 0 || waitpid(pid, NULL, WNOHANG) != 0)
+    return;
+  if (exiting_count == exiting_cap) {
+    int cap = exiting_cap ? exiting_cap * 2 : 16;
+    Exiting *grown = realloc(exiting, cap * sizeof(*grown));
+    if (!grown) {
+      waitpid(pid, NULL, 0);
+      return;
+    }
+    exiting = grown;
+    exiting_cap = cap;
+  }
+  int fd = child_watch(pid, WATCH_CHILD, exiting_count);
+  if (fd == -1)
+    waitpid(pid, NULL, 0);
+  else
+    exiting[exiting_count++] = (Exiting){pid, fd};
+}
+
+// Reaps the child whose pidfd at exiting[k] became readable.
+void reap_io(int k) {
+  if (k >= exiting_count || waitpid(exiting[k].pid, NULL, WNOHANG) == 0)
+    return;
+  unwatch_fd(exiting[k].pidfd);
+  close(exiting[k].pidfd);
+  exiting[k] = exiting[--exiting_count];
+  if (k < exiting_count)
+    watch_fd(exiting[k].pidfd, EPOLLIN, WATCH_CHILD, k);
+}
+
+// Waits for every child left by reap_child(); run on exit.
+void reap_children(void) {
+  for (int k = 0; k < exiting_count; k++) {
+    waitpid(exiting[k].pid, NULL, 0);
+    close(exiting[k].pidfd);
+  }
+  exiting_count = 0;
+  free(exiting);
+  exiting = NULL;
+  exiting_cap = 0;
+}
+
+// Runs `gh api -i` for the latest runs of repo, at most per_page of them,
+// printing the response headers and a fetch result (see the run history) on
+// the pipe stored in *out. A non-empty etag makes the request conditional.
+pid_t spawn_gh_fetch(const char *repo, const char *etag, int per_page,
+                     int *out) {
+  char path[320], header[160];
+  snprintf(path, sizeof(path), "repos/%s/actions/runs?per_page=%d", repo,
+           per_page);
+  snprintf(header, sizeof(header), "If-None-Match: %s", etag);
+  char *argv[] = {"gh",    "api",   "-i", path, "--jq", RUNS_JQ,
+                  etag[0] ? "-H" : NULL, header, NULL};
+  return spawn_reader(argv, out);
+}
+
+// Runs `gh repo list` for user, printing "nameWithOwner<TAB>default branch
+// <TAB>pushedAt" lines on the pipe stored in *out, most recently pushed
+// first. gh pages through the listing itself up to limit repos.
+pid_t spawn_repo_list(const char *user, const char *limit, int *out) {
+  char *argv[] = {"gh", "repo", "list", (char *)user, "--visibility", "all",
+                  "--limit", (char *)limit, "--json",
+                  "nameWithOwner,defaultBranchRef,pushedAt", "--jq",
+                  REPO_LIST_JQ, NULL};
+  return spawn_reader(argv, out);
+}
+
+const StatusEntry *status_details(const char *status) {
+  return &status_map[status ? status_classify(status) : ST_UNKNOWN];
+}
+
+const wchar_t *status_icon(const char *status) {
+  return status_details(status)->icon;
+}
+
+int status_color(const char *status) {
+  return status_details(status)->color;
+}
+
+void describe_status(const char *status, const char *fallback, char *buf,
+                     size_t len) {
+  if (!buf || len == 0)
+    return;
+  if (status && *status) {
+    size_t bi = 0;
+    for (const char *p = status; *p && bi + 1 < len; ++p) {
+      char ch = (*p == '_') ? ' ' : *p;
+      buf[bi++] = ch;
+    }
+    buf[bi] = '\0';
+    if (bi > 0)
+      return;
+  }
+  if (fallback) {
+    snprintf(buf, len, "%s", fallback);
+  } else {
+    buf[0] = '\0';
+  }
+}
+
+// Flags repo i's cell for the next frame.
+void mark_dirty(int i) { repo_dirty[i] = true; }
+
+// Records a fetched status for repo i. Returns true if the text changed.
+bool set_status(int i, const char *text) {
+  bool was_stale = status_stale[i];
+  uint16_t id = status_intern(text);
+  status_received[i] = 1;
+  if (status_id[i] == id) {
+    if (was_stale) {
+      repo_set_status_id(i, id, false);
+      mark_dirty(i);
+    }
+    return was_stale;
+  }
+  repo_set_status_id(i, id, false);
+  snapshot_dirty = true;
+  mark_dirty(i);
+  return true;
+}
+
+// Resets repo i to "loading" ahead of a fetch. Stale statuses stay on screen
+// until fresh data replaces them. Returns true if the status changed.
+bool mark_loading(int i) {
+  uint16_t loading = status_intern("loading");
+  if (status_stale[i] || status_id[i] == loading)
+    return false;
+  repo_set_status_id(i, loading, false);
+  status_received[i] = 0;
+  mark_dirty(i);
+  return true;
+}
+
+// ---- fetch queue shared by the engines ----
+
+void fetch_enqueue(int i, bool front) {
+  if (fetch_queued[i] || in_flight[i])
+    return;
+  fetch_queued[i] = true;
+  fetch_mark_us[i] = now_us();
+  if (front) {
+    fetch_qhead = (fetch_qhead + repo_cap - 1) % repo_cap;
+    fetch_queue[fetch_qhead] = i;
+  } else {
+    fetch_queue[(fetch_qhead + fetch_qlen) % repo_cap] = i;
+  }
+  fetch_qlen++;
+}
+
+// Pops the next queued repo and marks it in flight, tagged with the current
+// refresh generation.
+int fetch_dequeue(void) {
+  int i = fetch_queue[fetch_qhead];
+  fetch_qhead = (fetch_qhead + 1) % repo_cap;
+  fetch_qlen--;
+  fetch_queued[i] = false;
+  in_flight[i] = true;
+  fetch_gen[i] = fetch_generation;
+  long long now = now_us();
+  hist_record(&hists[HIST_QUEUE], now - fetch_mark_us[i]);
+  fetch_mark_us[i] = now;
+  return i;
+}
+
+void fetch_clear_queue(void) {
+  while (fetch_qlen > 0) {
+    fetch_queued[fetch_queue[fetch_qhead]] = false;
+    fetch_qhead = (fetch_qhead + 1) % repo_cap;
+    fetch_qlen--;
+  }
+}
+
+// Returns true if a result tagged gen answers the fetch repo i has in flight
+// rather than one that was cancelled or has since been started again.
+bool fetch_current(int i, uint32_t gen) {
+  return in_flight[i] && fetch_gen[i] == gen;
+}
+
+// ---- adaptive poll scheduler ----
+
+static int sched_len;
+static int sched_ceiling_s = POLL_INTERVAL_S;
+static bool sched_pushed; // webhooks report changes; polls only reconcile
+static bool sched_delta;  // delta passes report changes, see delta_poll()
+
+static void sched_swap(int a, int b) {
+  int t = sched_heap[a];
+  sched_heap[a] = sched_heap[b];
+  sched_heap[b] = t;
+  sched_pos[sched_heap[a]] = a + 1;
+  sched_pos[sched_heap[b]] = b + 1;
+}
+
+static bool sched_before(int a, int b) {
+  return next_due[sched_heap[a]] < next_due[sched_heap[b]];
+}
+
+static void sched_sift(int k) {
+  while (k > 0 && sched_before(k, (k - 1) / 2)) {
+    sched_swap(k, (k - 1) / 2);
+    k = (k - 1) / 2;
+  }
+  for (;;) {
+    int c = 2 * k + 1;
+    if (c >= sched_len)
+      break;
+    if (c + 1 < sched_len && sched_before(c + 1, c))
+      c++;
+    if (!sched_before(c, k))
+      break;
+    sched_swap(k, c);
+    k = c;
+  }
+}
+
+// Queues (or moves) repo i to be polled at due.
+void schedule_at(int i, long long due) {
+  next_due[i] = due;
+  if (sched_pos[i] == 0) {
+    sched_heap[sched_len] = i;
+    sched_pos[i] = ++sched_len;
+  }
+  sched_sift(sched_pos[i] - 1);
+}
+
+// Removes and returns the repo due soonest. The heap must not be empty.
+int schedule_pop(void) {
+  int i = sched_heap[0];
+  sched_swap(0, --sched_len);
+  sched_pos[i] = 0;
+  if (sched_len > 0)
+    sched_sift(0);
+  return i;
+}
+
+// Returns true while a workflow run is still going.
+bool status_active(const char *status) {
+  return strstr(status, "in_progress") || strstr(status, "queued") ||
+         strstr(status, "waiting") || strstr(status, "pending") ||
+         strstr(status, "requested");
+}
+
+// Picks when repo i is polled next: every few seconds while a run is active,
+// otherwise backing off exponentially from a short interval up to the poll
+// interval for as long as the status stays the same. With webhooks pushing
+// changes every repo is polled at the poll interval; with --delta the ceiling
+// is the slow sweep, since delta passes bring changed repos forward.
+void schedule_next(int i, bool changed) {
+  int ceiling = sched_ceiling_s;
+  int base = BACKOFF_BASE_S < ceiling ? BACKOFF_BASE_S : ceiling;
+  int interval;
+  if (sched_pushed) {
+    interval = ceiling;
+  } else if (status_active(repo_status(i))) {
+    interval = ACTIVE_POLL_S < ceiling ? ACTIVE_POLL_S : ceiling;
+    poll_backoff_s[i] = 0;
+  } else {
+    if (changed || poll_backoff_s[i] == 0)
+      poll_backoff_s[i] = base;
+    else if (poll_backoff_s[i] < ceiling / 2)
+      poll_backoff_s[i] *= 2;
+    else
+      poll_backoff_s[i] = ceiling;
+    interval = poll_backoff_s[i];
+  }
+  // +-10% jitter keeps repos that finished together from polling together
+  long long ms = interval * 1000LL;
+  schedule_at(i, now_ms() + ms - ms / 10 + rand() % (ms / 5 + 1));
+}
+
+// ---- rate limit budget ----
+
+typedef struct {
+  long remaining;   // X-RateLimit-Remaining, -1 if absent
+  long reset;       // X-RateLimit-Reset as a Unix time, 0 if absent
+  long retry_after; // Retry-After in seconds, 0 if absent
+} RateLimit;
+
+static long rate_remaining = -1; // last reported budget, -1 until known
+static time_t rate_reset;
+static time_t rate_blocked_until; // no requests before this time
+static double rate_tokens = RATE_BURST;
+static long long rate_refilled_ms;
+
+// Records one rate limit header line into rl if it is one.
+void rate_limit_header(const char *name, size_t nlen, const char *value,
+                       RateLimit *rl) {
+  if (nlen == 21 && strncasecmp(name, "x-ratelimit-remaining", nlen) == 0)
+    rl->remaining = strtol(value, NULL, 10);
+  else if (nlen == 17 && strncasecmp(name, "x-ratelimit-reset", nlen) == 0)
+    rl->reset = strtol(value, NULL, 10);
+  else if (nlen == 11 && strncasecmp(name, "retry-after", nlen) == 0)
+    rl->retry_after = strtol(value, NULL, 10);
+}
+
+// Tops up the token bucket at the rate that spreads the remaining budget
+// evenly until the reset time.
+static void rate_refill(void) {
+  long long now = now_ms();
+  if (rate_remaining >= 0 && rate_reset <= time(NULL)) {
+    // the window reset: the budget is full again until a response says
+    rate_remaining = -1;
+    rate_tokens = RATE_BURST;
+  }
+  if (rate_remaining >= 0 && rate_refilled_ms > 0) {
+    long long left_ms = (rate_reset - time(NULL)) * 1000LL;
+    if (left_ms < 1000)
+      left_ms = 1000;
+    rate_tokens += (double)rate_remaining * (now - rate_refilled_ms) / left_ms;
+    if (rate_tokens > RATE_BURST)
+      rate_tokens = RATE_BURST;
+  }
+  rate_refilled_ms = now;
+}
+
+// Folds the limits reported with a response into the budget. Returns true if
+// the response was a rate limit rejection rather than a real answer.
+bool rate_limit_update(int code, const RateLimit *rl) {
+  if (!rl)
+    return false;
+  time_t now = time(NULL);
+  rate_refill();
+  if (rl->remaining >= 0) {
+    rate_remaining = rl->remaining;
+    rate_reset = rl->reset;
+  }
+  if (code == 304 && rate_tokens + 1 <= RATE_BURST)
+    rate_tokens += 1; // conditional hits are not charged against the quota
+  bool limited = (code == 403 || code == 429) &&
+                 (rl->remaining == 0 || rl->retry_after > 0);
+  if (rl->retry_after > 0 && now + rl->retry_after > rate_blocked_until)
+    rate_blocked_until = now + rl->retry_after;
+  if (rl->remaining == 0 && rl->reset > rate_blocked_until)
+    rate_blocked_until = rl->reset;
+  if (limited && rate_blocked_until <= now)
+    rate_blocked_until = now + ACTIVE_POLL_S;
+  return limited;
+}
+
+// Returns the seconds until requests may be sent again, 0 if not blocked.
+long rate_limit_wait_s(void) {
+  time_t now = time(NULL);
+  return rate_blocked_until > now ? (long)(rate_blocked_until - now) : 0;
+}
+
+// Returns the ms until rate_limit_take() can next succeed.
+long long rate_limit_delay_ms(void) {
+  long wait_s = rate_limit_wait_s();
+  if (wait_s > 0)
+    return wait_s * 1000LL;
+  rate_refill();
+  if (rate_remaining < 0 || rate_tokens >= 1)
+    return 0;
+  long long left_ms = (rate_reset - time(NULL)) * 1000LL;
+  if (left_ms < 1000)
+    left_ms = 1000;
+  if (rate_remaining == 0)
+    return left_ms; // nothing refills before the reset
+  return (long long)((1 - rate_tokens) * left_ms / rate_remaining) + 1;
+}
+
+// Takes a token for one request. Returns false if the budget says to wait.
+bool rate_limit_take(void) {
+  if (rate_limit_wait_s() > 0)
+    return false;
+  if (rate_remaining < 0)
+    return true; // the server has not reported a budget
+  rate_refill();
+  if (rate_tokens < 1)
+    return false;
+  rate_tokens -= 1;
+  return true;
+}
+
+// ---- conditional request cache ----
+
+// A cached entry for a repo not in the table when the cache was loaded.
+typedef struct {
+  const char *repo, *etag;
+  uint16_t status;
+  bool adopted; // the repo has since been listed
+} EtagEntry;
+
+static EtagEntry *etag_extra; // sorted by repo for etag_adopt()
+static int etag_extra_count, etag_extra_cap;
+static bool etags_dirty;
+
+static int cmp_etag_entry(const void *a, const void *b) {
+  return strcmp(((const EtagEntry *)a)->repo, ((const EtagEntry *)b)->repo);
+}
+
+// Gives repo i, listed after the cache was loaded, its cached ETag.
+void etag_adopt(int i) {
+  EtagEntry key = {.repo = REPOS[i]};
+  EtagEntry *e = bsearch(&key, etag_extra, etag_extra_count,
+                         sizeof(*etag_extra), cmp_etag_entry);
+  if (!e || e->adopted)
+    return;
+  snprintf(repo_etag[i], sizeof(repo_etag[i]), "%s", e->etag);
+  etag_status[i] = e->status;
+  e->adopted = true;
+}
+
+// Returns the ETag to revalidate repo i's cached result with, or "" to fetch
+// it afresh. With --workflows a repo's first fetch is unconditional: a 304
+// would carry no runs to reduce, and the cached status may come from another
+// mode or branch filter. Likewise until the run history holds runs, as the
+// cached ETag may answer a smaller page, unless the repo had no runs at all.
+const char *fetch_etag(int i) {
+  if (!etag_status[i] || (workflow_mode && !workflow_text[i]))
+    return "";
+  if (run_history[i].count == 0 &&
+      strcmp(status_text(etag_status[i]), "no_runs") != 0)
+    return "";
+  return repo_etag[i];
+}
+
+// Copies the "status conclusion" part of a fetch result into status and
+// returns the run history after it, "" if there is none.
+const char *split_runs(const char *text, char *status, size_t len) {
+  size_t n = strcspn(text, "\t");
+  snprintf(status, len, "%.*s", (int)n, text);
+  return text[n] ? text + n + 1 : "";
+}
+
+// Applies a fetch result to repo i. A 304 keeps the status cached with the
+// ETag, a 200 replaces the cache entry and adds its runs to the history (and
+// with --workflows reduces them to a status per workflow), a rate limit
+// rejection keeps the previous status and anything else counts as no runs. rl
+// holds the response's rate limit headers, or is NULL if no response arrived.
+bool apply_fetch(int i, int code, const char *etag, const char *text,
+                 const RateLimit *rl) {
+  bool changed = false;
+  char status[64];
+  const char *runs = split_runs(text, status, sizeof(status));
+  if (fetch_mark_us[i]) {
+    hist_record(&hists[HIST_FETCH], now_us() - fetch_mark_us[i]);
+    fetch_mark_us[i] = 0;
+    telemetry_fetch_done();
+  }
+  refresh_left -= refresh_owed[i];
+  refresh_owed[i] = false;
+  if (rate_limit_update(code, rl)) {
+    // keep showing the last known status until the budget recovers
+    if (!status_received[i] && !status_stale[i])
+      changed = set_status(i, etag_status[i] ? status_text(etag_status[i])
+                                             : "rate_limited");
+    schedule_at(i, now_ms() + (rate_limit_wait_s() + 1) * 1000LL);
+    return changed;
+  }
+  if (code == 304 && etag_status[i]) {
+    changed = set_status(i, status_text(etag_status[i]));
+  } else if (code == 200 && status[0]) {
+    bool reduced =
+        workflow_mode && workflow_reduce(i, runs, status, sizeof(status));
+    uint16_t id = status_intern(status);
+    if (strcmp(repo_etag[i], etag) != 0 || etag_status[i] != id)
+      etags_dirty = true;
+    snprintf(repo_etag[i], sizeof(repo_etag[i]), "%s", etag);
+    etag_status[i] = id;
+    changed = set_status(i, status) || reduced;
+    if (reduced)
+      mark_dirty(i); // the hover and --attach clients list the workflows
+    if (history_apply(i, runs)) {
+      mark_dirty(i);
+      changed = true;
+    }
+  } else if (!status_received[i]) {
+    changed = set_status(i, "no_runs");
+  }
+  schedule_next(i, changed);
+  return changed;
+}
+
+// Splits `gh api -i` output into its HTTP status code, ETag header, rate
+// limit headers and the first line of the filtered body. Returns 0 if a status
+// line was found.
+int parse_gh_api_output(const char *out, int *code, char *etag,
+                        size_t etag_len, char *text, size_t text_len,
+                        RateLimit *rl) {
+  *code = 0;
+  etag[0] = text[0] = '\0';
+  *rl = (RateLimit){-1, 0, 0};
+  bool body = false;
+  for (const char *p = out; *p;) {
+    size_t n = strcspn(p, "\n");
+    size_t l = (n > 0 && p[n - 1] == '\r') ? n - 1 : n;
+    if (body) {
+      if (l > 0 && !text[0])
+        snprintf(text, text_len, "%.*s", (int)l, p);
+    } else if (*code == 0) {
+      if (sscanf(p, "HTTP/%*s %d", code) != 1)
+        return -1;
+    } else if (l == 0) {
+      body = true;
+    } else if (l > 5 && strncasecmp(p, "etag:", 5) == 0) {
+      size_t v = 5;
+      while (v < l && p[v] == ' ')
+        v++;
+      snprintf(etag, etag_len, "%.*s", (int)(l - v), p + v);
+    } else if (memchr(p, ':', l)) {
+      const char *colon = memchr(p, ':', l);
+      rate_limit_header(p, colon - p, colon + 1, rl);
+    }
+    p += n;
+    if (*p)
+      p++;
+  }
+  return *code ? 0 : -1;
+}
+
+// Joins name onto the ghstatus directory under $XDG_CACHE_HOME (or
+// ~/.cache), creating it if needed. Returns 0 on success.
+int cache_path(const char *name, char *buf, size_t len) {
+  const char *xdg = getenv("XDG_CACHE_HOME");
+  const char *home = getenv("HOME");
+  char dir[PATH_MAX];
+  if (xdg && *xdg) {
+    snprintf(dir, sizeof(dir), "%s", xdg);
+  } else if (home && *home) {
+    snprintf(dir, sizeof(dir), "%s/.cache", home);
+  } else {
+    return -1;
+  }
+  mkdir(dir, 0700);
+  strncat(dir, "/ghstatus", sizeof(dir) - strlen(dir) - 1);
+  if (mkdir(dir, 0700) == -1 && errno != EEXIST)
+    return -1;
+  if ((size_t)snprintf(buf, len, "%s/%s", dir, name) >= len)
+    return -1;
+  return 0;
+}
+
+// Reads "repo<TAB>etag<TAB>status" lines saved by an earlier run.
+void load_etags(void) {
+  char path[PATH_MAX];
+  if (cache_path("etags", path, sizeof(path)) != 0)
+    return;
+  FILE *fp = fopen(path, "r");
+  if (!fp)
+    return;
+
+  char line[512];
+  while (fgets(line, sizeof(line), fp)) {
+    line[strcspn(line, "\n")] = '\0';
+    char *etag = strchr(line, '\t');
+    char *text = etag ? strchr(etag + 1, '\t') : NULL;
+    if (!text)
+      continue;
+    *etag++ = '\0';
+    *text++ = '\0';
+
+    int i = repo_lookup(line);
+    if (i >= 0) {
+      snprintf(repo_etag[i], sizeof(repo_etag[i]), "%s", etag);
+      etag_status[i] = status_intern(text);
+      continue;
+    }
+    // keep the rest for repos listed later and for other dashboards
+    if (etag_extra_count == etag_extra_cap) {
+      int cap = etag_extra_cap ? etag_extra_cap * 2 : 256;
+      EtagEntry *grown = realloc(etag_extra, cap * sizeof(*grown));
+      if (!grown)
+        break;
+      etag_extra = grown;
+      etag_extra_cap = cap;
+    }
+    EtagEntry *e = &etag_extra[etag_extra_count];
+    e->repo = intern_name(line);
+    e->etag = intern_name(etag);
+    e->status = status_intern(text);
+    e->adopted = false;
+    if (e->repo && e->etag && e->status)
+      etag_extra_count++;
+  }
+  fclose(fp);
+  qsort(etag_extra, etag_extra_count, sizeof(*etag_extra), cmp_etag_entry);
+}
+
+void save_etags(void) {
+  char path[PATH_MAX], tmp[PATH_MAX + 8];
+  if (!etags_dirty || cache_path("etags", path, sizeof(path)) != 0)
+    return;
+  snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+  FILE *fp = fopen(tmp, "w");
+  if (!fp)
+    return;
+  for (int i = 0; i < NUM_REPOS; i++) {
+    if (repo_etag[i][0] && etag_status[i])
+      fprintf(fp, "%s\t%s\t%s\n", REPOS[i], repo_etag[i],
+              status_text(etag_status[i]));
+  }
+  for (int k = 0; k < etag_extra_count; k++) {
+    EtagEntry *e = &etag_extra[k];
+    if (!e->adopted)
+      fprintf(fp, "%s\t%s\t%s\n", e->repo, e->etag, status_text(e->status));
+  }
+  if (fclose(fp) == 0 && rename(tmp, path) == 0)
+    etags_dirty = false;
+  else
+    unlink(tmp);
+}
+
+// ---- warm start snapshot ----
+
+#define SNAPSHOT_MAGIC "GHSS"
+#define SNAPSHOT_VERSION 1
+
+typedef struct {
+  char magic[4];
+  uint32_t version;
+  uint32_t count;     // entries that follow the header
+  uint32_t sort_mode; // SortMode in effect when saved
+  uint32_t names_len; // bytes of NUL terminated names after the entries
+} SnapshotHeader;
+
+typedef struct {
+  uint32_t name;     // offset of the repo name in the names block
+  uint32_t order;    // repo shown at this display position
+  uint8_t received;  // status came from a fetch
+  char status[63];   // last known status text
+} SnapshotEntry;
+
+static char snapshot_file[PATH_MAX];
+static bool discovery_complete;    // every user's listing succeeded
+
+// Picks the snapshot file for this set of users.
+void snapshot_init(char **users, int count) {
+  unsigned h = 2166136261u;
+  for (int u = 0; u < count; u++) {
+    h = (h ^ hash_name(users[u])) * 16777619u;
+  }
+  char name[32];
+  snprintf(name, sizeof(name), "snapshot-%08x", h);
+  if (cache_path(name, snapshot_file, sizeof(snapshot_file)) != 0)
+    snapshot_file[0] = '\0';
+}
+
+// Maps the snapshot for this set of users and restores its repos, statuses
+// and display order, flagging every status as stale. Returns true if one was
+// loaded.
+bool load_snapshot(void) {
+  if (!snapshot_file[0])
+    return false;
+  int fd = open(snapshot_file, O_RDONLY | O_CLOEXEC);
+  if (fd == -1)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(SnapshotHeader)) {
+    close(fd);
+    return false;
+  }
+  size_t size = st.st_size;
+  const char *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return false;
+
+  const SnapshotHeader *hdr = (const SnapshotHeader *)map;
+  const SnapshotEntry *entries = (const SnapshotEntry *)(hdr + 1);
+  const char *names = (const char *)(entries + hdr->count);
+  bool ok = memcmp(hdr->magic, SNAPSHOT_MAGIC, 4) == 0 &&
+            hdr->version == SNAPSHOT_VERSION &&
+            sizeof(*hdr) + (size_t)hdr->count * sizeof(*entries) +
+                    hdr->names_len ==
+                size &&
+            hdr->names_len > 0 && names[hdr->names_len - 1] == '\0';
+  for (uint32_t k = 0; ok && k < hdr->count; k++) {
+    ok = entries[k].name < hdr->names_len && entries[k].order < hdr->count;
+  }
+
+  if (ok) {
+    for (uint32_t k = 0; k < hdr->count; k++) {
+      int i = repo_add(names + entries[k].name);
+      if (i < 0)
+        break;
+      char status[sizeof(entries[k].status) + 1];
+      snprintf(status, sizeof(status), "%.*s",
+               (int)sizeof(entries[k].status), entries[k].status);
+      repo_set_status_id(i, status_intern(status), true);
+      status_received[i] = entries[k].received;
+    }
+    for (int k = 0; k < NUM_REPOS; k++) {
+      order[k] = (int)entries[k].order < NUM_REPOS ? (int)entries[k].order : k;
+    }
+    if (hdr->sort_mode <= SORT_STATUS)
+      sort_mode = hdr->sort_mode;
+    // keep the saved order on screen instead of sorting again; later status
+    // changes move repos from there with order_reposition()
+    bool placed = NUM_REPOS == (int)hdr->count;
+    for (int k = 0; k < NUM_REPOS; k++)
+      order_pos[k] = -1;
+    for (int k = 0; placed && k < NUM_REPOS; k++) {
+      placed = order_pos[order[k]] == -1;
+      order_pos[order[k]] = k;
+    }
+    if (placed) {
+      alpha_rebuild();
+      order_dirty = false;
+      filter_dirty = true;
+    }
+  }
+  munmap((void *)map, size);
+  return NUM_REPOS > 0;
+}
+
+// Writes the repo table to the snapshot file. Once discovery has confirmed
+// the full listing, repos it no longer returns are left out.
+void save_snapshot(void) {
+  if (!snapshot_file[0] || NUM_REPOS == 0)
+    return;
+
+  int *remap = malloc(NUM_REPOS * sizeof(*remap));
+  if (!remap)
+    return;
+  SnapshotHeader hdr = {SNAPSHOT_MAGIC, SNAPSHOT_VERSION, 0, sort_mode, 0};
+  for (int i = 0; i < NUM_REPOS; i++) {
+    if (discovery_complete && !discovered[i]) {
+      remap[i] = -1;
+      continue;
+    }
+    remap[i] = hdr.count++;
+    hdr.names_len += strlen(REPOS[i]) + 1;
+  }
+
+  SnapshotEntry *entries = calloc(hdr.count ? hdr.count : 1, sizeof(*entries));
+  if (!entries) {
+    free(remap);
+    return;
+  }
+  uint32_t name = 0, pos = 0;
+  for (int i = 0; i < NUM_REPOS; i++) {
+    if (remap[i] < 0)
+      continue;
+    SnapshotEntry *e = &entries[remap[i]];
+    e->name = name;
+    e->received = status_received[i] != 0;
+    strncpy(e->status, repo_status(i), sizeof(e->status));
+    name += strlen(REPOS[i]) + 1;
+  }
+  for (int k = 0; k < NUM_REPOS; k++) {
+    if (remap[order[k]] >= 0)
+      entries[pos++].order = remap[order[k]];
+  }
+
+  char tmp[PATH_MAX + 8];
+  snprintf(tmp, sizeof(tmp), "%s.tmp", snapshot_file);
+  FILE *fp = fopen(tmp, "wb");
+  if (fp) {
+    fwrite(&hdr, sizeof(hdr), 1, fp);
+    fwrite(entries, sizeof(*entries), hdr.count, fp);
+    for (int i = 0; i < NUM_REPOS; i++) {
+      if (remap[i] >= 0)
+        fwrite(REPOS[i], 1, strlen(REPOS[i]) + 1, fp);
+    }
+    if (fclose(fp) == 0 && rename(tmp, snapshot_file) == 0)
+      snapshot_dirty = false;
+    else
+      unlink(tmp);
+  }
+  free(entries);
+  free(remap);
+}
+
+// ---- minimal JSON tokenizer ----
+
+typedef enum {
+  JSON_OBJECT = 1,
+  JSON_ARRAY,
+  JSON_STRING,
+  JSON_PRIMITIVE
+} JsonType;
+
+typedef struct {
+  JsonType type;
+  int start, end; // byte range, strings exclude their quotes
+  int size;       // keys of an object, elements of an array, 1 for a key
+} JsonToken;
+
+// Tokenizes js into at most max tokens in document order. Returns the token
+// count, or -1 if the input is malformed or too large.
+int json_parse(const char *js, size_t len, JsonToken *toks, int max) {
+  int stack[64];
+  int depth = 0;
+  int super = -1; // token that receives the next value
+  int n = 0;
+
+  for (size_t p = 0; p < len; p++) {
+    char c = js[p];
+    switch (c) {
+    case '{':
+    case '[':
+      if (n >= max || depth >= (int)(sizeof(stack) / sizeof(stack[0])))
+        return -1;
+      if (super != -1)
+        toks[super].size++;
+      toks[n] = (JsonToken){c == '{' ? JSON_OBJECT : JSON_ARRAY, (int)p, -1, 0};
+      stack[depth++] = n;
+      super = n++;
+      break;
+    case '}':
+    case ']':
+      if (depth == 0)
+        return -1;
+      toks[stack[--depth]].end = (int)p + 1;
+      super = depth > 0 ? stack[depth - 1] : -1;
+      break;
+    case '"': {
+      size_t start = ++p;
+      while (p < len && js[p] != '"') {
+        if (js[p] == '\\')
+          p++;
+        p++;
+      }
+      if (p >= len || n >= max)
+        return -1;
+      if (super != -1)
+        toks[super].size++;
+      toks[n++] = (JsonToken){JSON_STRING, (int)start, (int)p, 0};
+      break;
+    }
+    case ':':
+      super = n - 1;
+      break;
+    case ',':
+      super = depth > 0 ? stack[depth - 1] : -1;
+      break;
+    case ' ':
+    case '\t':
+    case '\r':
+    case '\n':
+      break;
+    default: {
+      size_t start = p;
+      while (p < len && !strchr(",]} \t\r\n", js[p]))
+        p++;
+      if (n >= max)
+        return -1;
+      if (super != -1)
+        toks[super].size++;
+      toks[n++] = (JsonToken){JSON_PRIMITIVE, (int)start, (int)p, 0};
+      p--;
+      break;
+    }
+    }
+  }
+  return depth == 0 ? n : -1;
+}
+
+// Returns the index just past token i and everything nested inside it.
+int json_skip(const JsonToken *t, int n, int i) {
+  int pending = 1;
+  while (pending > 0 && i < n) {
+    pending += t[i].size - 1;
+    i++;
+  }
+  return i;
+}
+
+// Returns the value token stored under key in object obj, or -1.
+int json_get(const char *js, const JsonToken *t, int n, int obj,
+             const char *key) {
+  if (obj < 0 || obj >= n || t[obj].type != JSON_OBJECT)
+    return -1;
+  size_t klen = strlen(key);
+  int j = obj + 1;
+  for (int k = 0; k < t[obj].size && j + 1 < n; k++) {
+    if (t[j].type == JSON_STRING && (size_t)(t[j].end - t[j].start) == klen &&
+        memcmp(js + t[j].start, key, klen) == 0)
+      return j + 1;
+    j = json_skip(t, n, j + 1);
+  }
+  return -1;
+}
+
+// Returns element idx of array arr, or -1.
+int json_at(const JsonToken *t, int n, int arr, int idx) {
+  if (arr < 0 || arr >= n || t[arr].type != JSON_ARRAY || idx >= t[arr].size)
+    return -1;
+  int j = arr + 1;
+  while (idx-- > 0)
+    j = json_skip(t, n, j);
+  return j;
+}
+
+// Returns the seconds since the epoch of ISO 8601 UTC time s, or 0 if it is
+// not one.
+long iso_time(const char *s) {
+  struct tm tm = {0};
+  const char *end = strptime(s, "%Y-%m-%dT%H:%M:%S", &tm);
+  return end ? (long)timegm(&tm) : 0;
+}
+
+// Copies the text of token i into buf, undoing simple string escapes.
+void json_text(const char *js, const JsonToken *t, int i, char *buf,
+               size_t len) {
+  size_t bi = 0;
+  if (i >= 0) {
+    for (int p = t[i].start; p < t[i].end && bi + 1 < len; p++) {
+      char ch = js[p];
+      if (ch == '\\' && p + 1 < t[i].end) {
+        ch = js[++p];
+        if (ch == 'n')
+          ch = ' ';
+        else if (ch == 't')
+          ch = ' ';
+        else if (ch == 'u')
+          p += 4, ch = '?';
+      }
+      buf[bi++] = ch;
+    }
+  }
+  buf[bi] = '\0';
+}
+
+// Returns the seconds since the epoch of the ISO 8601 UTC time in token i,
+// or 0 if it has none.
+static long json_time(const char *js, const JsonToken *t, int i) {
+  char buf[32];
+  json_text(js, t, i, buf, sizeof(buf));
+  return iso_time(buf);
+}
+
+// Replaces the characters of from in s with to.
+static void replace_chars(char *s, const char *from, char to) {
+  for (; *s; s++) {
+    if (strchr(from, *s))
+      *s = to;
+  }
+}
+
+// Reduces a workflow runs listing to the text the gh engine produces:
+// "status conclusion" of its newest run, a tab and "id status conclusion
+// seconds workflow branch name" of each run joined by semicolons. Empty
+// listings give "no_runs".
+int parse_runs_status(const char *js, size_t len, char *out, size_t outlen) {
+  int max = (int)(len / 2) + 2;
+  JsonToken *t = malloc((size_t)max * sizeof(*t));
+  if (!t)
+    return -1;
+  int rc = -1;
+  int n = json_parse(js, len, t, max);
+  if (n > 0) {
+    int runs = json_get(js, t, n, 0, "workflow_runs");
+    if (runs >= 0 && t[runs].type == JSON_ARRAY) {
+      snprintf(out, outlen, "no_runs");
+      size_t used = 0;
+      for (int k = 0, run; (run = json_at(t, n, runs, k)) >= 0; k++) {
+        char id[24], status[32], conclusion[32], workflow[24], branch[64];
+        char name[64];
+        json_text(js, t, json_get(js, t, n, run, "id"), id, sizeof(id));
+        json_text(js, t, json_get(js, t, n, run, "workflow_id"), workflow,
+                  sizeof(workflow));
+        int b = json_get(js, t, n, run, "head_branch");
+        int m = json_get(js, t, n, run, "name");
+        json_text(js, t, b >= 0 && t[b].type == JSON_STRING ? b : -1, branch,
+                  sizeof(branch));
+        json_text(js, t, m >= 0 && t[m].type == JSON_STRING ? m : -1, name,
+                  sizeof(name));
+        replace_chars(branch, "; ", '_');
+        replace_chars(name, ";", ' ');
+        json_text(js, t, json_get(js, t, n, run, "status"), status,
+                  sizeof(status));
+        json_text(js, t, json_get(js, t, n, run, "conclusion"), conclusion,
+                  sizeof(conclusion));
+        int started = json_get(js, t, n, run, "run_started_at");
+        if (started < 0)
+          started = json_get(js, t, n, run, "created_at");
+        int updated = json_get(js, t, n, run, "updated_at");
+        long seconds = json_time(js, t, updated) - json_time(js, t, started);
+        if (k == 0 && (used = snprintf(out, outlen, "%s %s\t", status,
+                                       conclusion)) >= outlen)
+          break;
+        size_t w = snprintf(out + used, outlen - used,
+                            "%s%s %s %s %ld %s %s %s", k ? ";" : "", id,
+                            status, conclusion, seconds,
+                            workflow[0] ? workflow : "null",
+                            branch[0] ? branch : "-", name);
+        if (used + w >= outlen) {
+          out[used] = '\0'; // keep whole runs only
+          break;
+        }
+        used += w;
+      }
+      rc = 0;
+    }
+  }
+  free(t);
+  return rc;
+}
+
+// Reads a webhook payload for event. A workflow_run stores its repo's
+// "status conclusion" and the run, as parse_runs_status() does, in out and
+// returns 1; a workflow_job only says the
+// repo's latest run moved, so it returns 2 with out empty. Other events
+// return 0, malformed payloads -1.
+int parse_webhook(const char *event, const char *js, size_t len, char *repo,
+                  size_t repolen, char *out, size_t outlen) {
+  bool run = strcmp(event, "workflow_run") == 0;
+  if (!run && strcmp(event, "workflow_job") != 0)
+    return 0;
+  int max = (int)(len / 2) + 2;
+  JsonToken *t = malloc((size_t)max * sizeof(*t));
+  if (!t)
+    return -1;
+  int rc = -1;
+  int n = json_parse(js, len, t, max);
+  int obj = n > 0 ? json_get(js, t, n, 0, run ? "workflow_run" : "workflow_job")
+                  : -1;
+  int name = json_get(js, t, n, json_get(js, t, n, 0, "repository"),
+                      "full_name");
+  if (obj >= 0 && name >= 0) {
+    json_text(js, t, name, repo, repolen);
+    out[0] = '\0';
+    rc = 2;
+    if (run) {
+      char id[24], status[32], conclusion[32];
+      json_text(js, t, json_get(js, t, n, obj, "id"), id, sizeof(id));
+      json_text(js, t, json_get(js, t, n, obj, "status"), status,
+                sizeof(status));
+      json_text(js, t, json_get(js, t, n, obj, "conclusion"), conclusion,
+                sizeof(conclusion));
+      long seconds =
+          json_time(js, t, json_get(js, t, n, obj, "updated_at")) -
+          json_time(js, t, json_get(js, t, n, obj, "run_started_at"));
+      snprintf(out, outlen, "%s %s", status, conclusion);
+      if (id[0])
+        snprintf(out + strlen(out), outlen - strlen(out), "\t%s %s %s %ld", id,
+                 status, conclusion, seconds);
+      rc = 1;
+    }
+  }
+  free(t);
+  return rc;
+}
+
+// ---- native HTTP engine ----
+
+typedef struct {
+  bool tls;
+  char host[256];
+  char port[8];
+  char prefix[256]; // path prefix without a trailing slash
+} ApiBase;
+
+// Splits an http(s)://host[:port][/prefix] URL. Returns 0 on success.
+int parse_api_url(const char *url, ApiBase *out) {
+  memset(out, 0, sizeof(*out));
+  const char *p;
+  if (strncmp(url, "https://", 8) == 0) {
+    out->tls = true;
+    p = url + 8;
+  } else if (strncmp(url, "http://", 7) == 0) {
+    p = url + 7;
+  } else {
+    return -1;
+  }
+
+  size_t hlen = strcspn(p, ":/");
+  if (hlen == 0 || hlen >= sizeof(out->host))
+    return -1;
+  memcpy(out->host, p, hlen);
+  p += hlen;
+
+  if (*p == ':') {
+    size_t plen = strspn(++p, "0123456789");
+    if (plen == 0 || plen >= sizeof(out->port))
+      return -1;
+    memcpy(out->port, p, plen);
+    p += plen;
+  } else {
+    strcpy(out->port, out->tls ? "443" : "80");
+  }
+  if (*p && *p != '/')
+    return -1;
+
+  size_t plen = strlen(p);
+  while (plen > 0 && p[plen - 1] == '/')
+    plen--;
+  if (plen >= sizeof(out->prefix))
+    return -1;
+  memcpy(out->prefix, p, plen);
+  return 0;
+}
+
+typedef struct {
+  int code;
+  bool keep_alive;
+  const char *hdrs, *hdrs_end; // header lines after the status line
+  char *body;
+  size_t body_len;
+} HttpResponse;
+
+// Finds header name in the block [p, end) and returns its value, storing the
+// value's length in *len, or NULL if the header is absent.
+const char *http_header(const char *p, const char *end, const char *name,
+                        size_t *len) {
+  size_t nlen = strlen(name);
+  while (p < end) {
+    const char *eol = memmem(p, end - p, "\r\n", 2);
+    if (!eol)
+      eol = end;
+    if ((size_t)(eol - p) > nlen && p[nlen] == ':' &&
+        strncasecmp(p, name, nlen) == 0) {
+      const char *v = p + nlen + 1;
+      while (v < eol && (*v == ' ' || *v == '\t'))
+        v++;
+      *len = eol - v;
+      return v;
+    }
+    p = eol + 2;
+  }
+  return NULL;
+}
+
+// Parses one response from buf[0..len), which must be NUL terminated.
+// Returns the bytes it spans once complete, 0 if more data is needed and -1
+// if it is malformed. Chunked bodies are decoded in place. With eof set, a
+// body without a length runs to the end of the buffer.
+long http_parse_response(char *buf, size_t len, bool eof, HttpResponse *resp) {
+  char *hend = memmem(buf, len, "\r\n\r\n", 4);
+  if (!hend)
+    return len > 65536 ? -1 : 0;
+  size_t hlen = hend - buf + 4;
+
+  int minor, code;
+  if (sscanf(buf, "HTTP/1.%d %d", &minor, &code) != 2)
+    return -1;
+  resp->code = code;
+  resp->keep_alive = minor >= 1;
+  resp->body = buf + hlen;
+  resp->body_len = 0;
+
+  size_t vlen;
+  const char *hdrs = (char *)memchr(buf, '\n', hlen) + 1;
+  resp->hdrs = hdrs;
+  resp->hdrs_end = hend + 2;
+  const char *v = http_header(hdrs, hend + 2, "Connection", &vlen);
+  if (v && vlen == 5 && strncasecmp(v, "close", 5) == 0)
+    resp->keep_alive = false;
+  else if (v && vlen == 10 && strncasecmp(v, "keep-alive", 10) == 0)
+    resp->keep_alive = true;
+
+  if (code < 200 || code == 204 || code == 304)
+    return (long)hlen;
+
+  char *body = resp->body;
+  size_t avail = len - hlen;
+  v = http_header(hdrs, hend + 2, "Transfer-Encoding", &vlen);
+  if (v && vlen >= 7 && strncasecmp(v + vlen - 7, "chunked", 7) == 0) {
+    size_t pos = 0;
+    long total;
+    for (;;) { // make sure every chunk has arrived before decoding
+      char *eol = memmem(body + pos, avail - pos, "\r\n", 2);
+      if (!eol)
+        return 0;
+      char *end;
+      unsigned long n = strtoul(body + pos, &end, 16);
+      if (end == body + pos)
+        return -1;
+      size_t data = eol - body + 2;
+      if (n == 0) {
+        char *tend =
+            memmem(body + data - 2, avail - data + 2, "\r\n\r\n", 4);
+        if (!tend)
+          return 0;
+        total = tend + 4 - buf;
+        break;
+      }
+      if (n > LONG_MAX - len)
+        return -1; // a size no response could reach
+      if (n > avail - data || avail - data - n < 2)
+        return 0; // checked before adding n, which could wrap
+      pos = data + n + 2;
+    }
+    size_t out = 0;
+    pos = 0;
+    for (;;) {
+      unsigned long n = strtoul(body + pos, NULL, 16);
+      if (n == 0)
+        break;
+      char *eol = memmem(body + pos, avail - pos, "\r\n", 2);
+      size_t data = eol - body + 2;
+      memmove(body + out, body + data, n);
+      out += n;
+      pos = data + n + 2;
+    }
+    body[out] = '\0';
+    resp->body_len = out;
+    return total;
+  }
+
+  v = http_header(hdrs, hend + 2, "Content-Length", &vlen);
+  if (v) {
+    size_t n = strtoul(v, NULL, 10);
+    if (avail < n)
+      return 0;
+    resp->body_len = n;
+    return (long)(hlen + n);
+  }
+
+  resp->keep_alive = false; // delimited by the connection closing
+  if (!eof)
+    return 0;
+  resp->body_len = avail;
+  return (long)len;
+}
+
+typedef enum {
+  CONN_CLOSED,
+  CONN_CONNECTING,
+  CONN_HANDSHAKE,
+  CONN_IDLE,
+  CONN_SENDING,
+  CONN_RECEIVING,
+} ConnState;
+
+typedef struct {
+  int fd;
+  SSL *ssl;
+  ConnState state;
+  int repo;     // repo being fetched, -1 when none
+  uint32_t events; // epoll events the connection is waiting on
+  int served;   // responses read over this connection
+  char req[1024];
+  size_t req_len, req_off;
+  char *buf;
+  size_t len, cap;
+} HttpConn;
+
+static ApiBase api;
+static struct addrinfo *api_addr;
+static SSL_CTX *ssl_ctx;
+static char api_token[256];
+static HttpConn http_conns[MAX_HTTP_CONNS];
+static int http_nconns;
+
+// Reads the API token from GH_TOKEN/GITHUB_TOKEN or `gh auth token`.
+void load_token(char *buf, size_t len) {
+  buf[0] = '\0';
+  const char *env = getenv("GH_TOKEN");
+  if (!env || !*env)
+    env = getenv("GITHUB_TOKEN");
+  if (env && *env) {
+    snprintf(buf, len, "%s", env);
+    return;
+  }
+
+  char *argv[] = {"gh", "auth", "token", NULL};
+  int fd;
+  pid_t pid = spawn_reader(argv, &fd);
+  if (pid == -1)
+    return;
+  size_t n = 0;
+  ssize_t r;
+  while (n + 1 < len && (r = read(fd, buf + n, len - n - 1)) > 0)
+    n += r;
+  buf[n] = '\0';
+  buf[strcspn(buf, "\r\n")] = '\0';
+  close(fd);
+  waitpid(pid, NULL, 0);
+}
+
+int http_init(const char *url, int max_conns) {
+  if (parse_api_url(url, &api) != 0) {
+    fprintf(stderr, "Invalid API URL '%s'.\n", url);
+    return -1;
+  }
+
+  struct addrinfo hints = {0};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  int rc = getaddrinfo(api.host, api.port, &hints, &api_addr);
+  if (rc != 0) {
+    fprintf(stderr, "Failed to resolve %s: %s\n", api.host, gai_strerror(rc));
+    return -1;
+  }
+
+  if (api.tls) {
+    ssl_ctx = SSL_CTX_new(TLS_client_method());
+    if (!ssl_ctx) {
+      fprintf(stderr, "Failed to initialise TLS.\n");
+      return -1;
+    }
+    SSL_CTX_set_default_verify_paths(ssl_ctx);
+    SSL_CTX_set_verify(ssl_ctx, SSL_VERIFY_PEER, NULL);
+  }
+
+  load_token(api_token, sizeof(api_token));
+
+  http_nconns = max_conns < MAX_HTTP_CONNS ? max_conns : MAX_HTTP_CONNS;
+  for (int k = 0; k < http_nconns; k++) {
+    http_conns[k].fd = -1;
+    http_conns[k].repo = -1;
+  }
+  return 0;
+}
+
+// Sets the events c waits for, updating its event loop registration.
+void http_want(HttpConn *c, uint32_t events) {
+  if (c->events != events)
+    watch_fd(c->fd, events, WATCH_ENGINE, c - http_conns);
+  c->events = events;
+}
+
+void http_close(HttpConn *c) {
+  if (c->ssl) {
+    SSL_free(c->ssl);
+    c->ssl = NULL;
+  }
+  unwatch_fd(c->fd);
+  if (c->fd != -1)
+    close(c->fd);
+  c->fd = -1;
+  c->state = CONN_CLOSED;
+  c->events = 0;
+}
+
+// Stores the outcome of the request on c; resp is NULL if it failed.
+bool http_finish(HttpConn *c, const HttpResponse *resp) {
+  int i = c->repo;
+  c->repo = -1;
+  in_flight[i] = false;
+  if (!resp)
+    return apply_fetch(i, 0, "", "", NULL);
+
+  char etag[96] = "", text[FETCH_TEXT_MAX] = "";
+  size_t vlen;
+  const char *v = http_header(resp->hdrs, resp->hdrs_end, "ETag", &vlen);
+  if (v)
+    snprintf(etag, sizeof(etag), "%.*s", (int)vlen, v);
+  RateLimit rl = {-1, 0, 0};
+  static const char *const limit_headers[] = {
+      "X-RateLimit-Remaining", "X-RateLimit-Reset", "Retry-After"};
+  for (size_t k = 0; k < 3; k++) {
+    const char *name = limit_headers[k];
+    if ((v = http_header(resp->hdrs, resp->hdrs_end, name, &vlen)))
+      rate_limit_header(name, strlen(name), v, &rl);
+  }
+  if (resp->code == 200)
+    parse_runs_status(resp->body, resp->body_len, text, sizeof(text));
+  return apply_fetch(i, resp->code, etag, text, &rl);
+}
+
+// Handles a transport failure on c, retrying once if a reused keep-alive
+// connection was closed before any of the response arrived.
+bool http_fail(HttpConn *c) {
+  bool stale = c->served > 0 && c->len == 0;
+  http_close(c);
+  if (c->repo == -1)
+    return false;
+  if (stale) {
+    int i = c->repo;
+    c->repo = -1;
+    in_flight[i] = false;
+    fetch_enqueue(i, true);
+    return false;
+  }
+  return http_finish(c, NULL);
+}
+
+// Maps the last TLS or socket call result to poll events. Returns false if
+// the connection failed.
+bool http_would_block(HttpConn *c, int rc) {
+  if (c->ssl) {
+    int err = SSL_get_error(c->ssl, rc);
+    if (err == SSL_ERROR_WANT_READ) {
+      http_want(c, EPOLLIN);
+      return true;
+    }
+    if (err == SSL_ERROR_WANT_WRITE) {
+      http_want(c, EPOLLOUT);
+      return true;
+    }
+    ERR_clear_error();
+    return false;
+  }
+  return rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+bool http_write(HttpConn *c) {
+  while (c->req_off < c->req_len) {
+    const char *p = c->req + c->req_off;
+    int n = (int)(c->req_len - c->req_off);
+    int rc = c->ssl ? SSL_write(c->ssl, p, n) : (int)send(c->fd, p, n, 0);
+    if (rc <= 0) {
+      if (http_would_block(c, rc)) {
+        if (!c->ssl)
+          http_want(c, EPOLLOUT);
+        return false;
+      }
+      return http_fail(c);
+    }
+    c->req_off += rc;
+  }
+  c->state = CONN_RECEIVING;
+  http_want(c, EPOLLIN);
+  c->len = 0;
+  return false;
+}
+
+bool http_send(HttpConn *c) {
+  const char *etag = fetch_etag(c->repo); // revalidate a cached status
+  if (!etag[0])
+    etag = NULL;
+  bool default_port = strcmp(api.port, api.tls ? "443" : "80") == 0;
+  int n = snprintf(c->req, sizeof(c->req),
+                   "GET %s/repos/%s/actions/runs?per_page=%d HTTP/1.1\r\n"
+                   "Host: %s%s%s\r\n"
+                   "User-Agent: ghstatus\r\n"
+                   "Accept: application/vnd.github+json\r\n"
+                   "%s%s%s"
+                   "%s%s%s"
+                   "\r\n",
+                   api.prefix, REPOS[c->repo], history_page(c->repo), api.host,
+                   default_port ? "" : ":", default_port ? "" : api.port,
+                   api_token[0] ? "Authorization: Bearer " : "", api_token,
+                   api_token[0] ? "\r\n" : "", etag ? "If-None-Match: " : "",
+                   etag ? etag : "", etag ? "\r\n" : "");
+  if (n < 0 || (size_t)n >= sizeof(c->req)) {
+    c->state = CONN_IDLE;
+    http_want(c, EPOLLIN);
+    return http_finish(c, NULL);
+  }
+  c->req_len = n;
+  c->req_off = 0;
+  c->state = CONN_SENDING;
+  return http_write(c);
+}
+
+bool http_handshake(HttpConn *c) {
+  int rc = SSL_connect(c->ssl);
+  if (rc == 1)
+    return http_send(c);
+  if (http_would_block(c, rc))
+    return false;
+  return http_fail(c);
+}
+
+bool http_connect(HttpConn *c) {
+  c->served = 0;
+  c->len = 0;
+  c->fd = socket(api_addr->ai_family,
+                 api_addr->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                 api_addr->ai_protocol);
+  if (c->fd == -1)
+    return http_finish(c, NULL);
+  int one = 1;
+  setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  c->state = CONN_CONNECTING;
+  http_want(c, EPOLLOUT);
+  if (connect(c->fd, api_addr->ai_addr, api_addr->ai_addrlen) == -1 &&
+      errno != EINPROGRESS)
+    return http_fail(c);
+  return false;
+}
+
+// Called once the socket is writable after a non-blocking connect.
+bool http_connected(HttpConn *c) {
+  int err = 0;
+  socklen_t elen = sizeof(err);
+  if (getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &elen) == -1 || err != 0)
+    return http_fail(c);
+  if (!api.tls)
+    return http_send(c);
+
+  c->ssl = SSL_new(ssl_ctx);
+  if (!c->ssl)
+    return http_fail(c);
+  SSL_set_fd(c->ssl, c->fd);
+  SSL_set_tlsext_host_name(c->ssl, api.host);
+  SSL_set1_host(c->ssl, api.host);
+  c->state = CONN_HANDSHAKE;
+  return http_handshake(c);
+}
+
+bool http_read(HttpConn *c) {
+  bool eof = false;
+  for (;;) {
+    if (c->cap - c->len < 4096) {
+      size_t cap = c->cap ? c->cap * 2 : 16384;
+      char *buf = realloc(c->buf, cap + 1);
+      if (!buf)
+        return http_fail(c);
+      c->buf = buf;
+      c->cap = cap;
+    }
+    int n = (int)(c->cap - c->len);
+    int rc = c->ssl ? SSL_read(c->ssl, c->buf + c->len, n)
+                    : (int)recv(c->fd, c->buf + c->len, n, 0);
+    if (rc > 0) {
+      c->len += rc;
+      continue;
+    }
+    if (rc < 0 || c->ssl) {
+      if (http_would_block(c, rc))
+        break;
+      if (!c->ssl || SSL_get_error(c->ssl, rc) != SSL_ERROR_ZERO_RETURN)
+        return http_fail(c);
+    }
+    eof = true;
+    break;
+  }
+  c->buf[c->len] = '\0';
+
+  if (c->state != CONN_RECEIVING) { // idle connection closed by the server
+    c->len = 0;
+    if (eof)
+      http_close(c);
+    return false;
+  }
+
+  HttpResponse resp;
+  long used = http_parse_response(c->buf, c->len, eof, &resp);
+  if (used == 0 && !eof)
+    return false;
+  if (used <= 0)
+    return http_fail(c);
+
+  c->served++;
+  bool changed = http_finish(c, &resp);
+  c->len = 0;
+  if (resp.keep_alive && !eof) {
+    c->state = CONN_IDLE;
+    http_want(c, EPOLLIN);
+  } else {
+    http_close(c);
+  }
+  return changed;
+}
+
+// Hands queued repos to free connections, opening new ones as needed.
+bool http_pump(void) {
+  bool changed = false;
+  for (int k = 0; k < http_nconns && fetch_qlen > 0; k++) {
+    HttpConn *c = &http_conns[k];
+    if (c->repo != -1 ||
+        (c->state != CONN_IDLE && c->state != CONN_CLOSED))
+      continue;
+    c->repo = fetch_dequeue();
+    changed |= c->state == CONN_IDLE ? http_send(c) : http_connect(c);
+  }
+  return changed;
+}
+
+// Advances connection c after the event loop reported it ready.
+bool http_io(HttpConn *c) {
+  bool changed;
+  switch (c->state) {
+  case CONN_CONNECTING:
+    changed = http_connected(c);
+    break;
+  case CONN_HANDSHAKE:
+    changed = http_handshake(c);
+    break;
+  case CONN_SENDING:
+    changed = http_write(c);
+    break;
+  case CONN_IDLE:
+  case CONN_RECEIVING:
+    changed = http_read(c);
+    break;
+  default:
+    changed = false;
+    break;
+  }
+  return http_pump() || changed;
+}
+
+void http_shutdown(void) {
+  for (int k = 0; k < http_nconns; k++) {
+    http_close(&http_conns[k]);
+    free(http_conns[k].buf);
+    http_conns[k].buf = NULL;
+  }
+  if (ssl_ctx)
+    SSL_CTX_free(ssl_ctx);
+  if (api_addr)
+    freeaddrinfo(api_addr);
+  ssl_ctx = NULL;
+  api_addr = NULL;
+}
+
+// ---- persistent gh workers ----
+
+typedef struct {
+  pid_t pid;
+  int in;   // write end of the worker's stdin, -1 if not running
+  int out;  // read end of the worker's stdout
+  int repo; // repo the worker is fetching, -1 when idle
+  char line[FETCH_TEXT_MAX + 512];
+  size_t len;
+} Worker;
+
+static Worker workers[MAX_WORKERS];
+static int num_workers;
+
+// Body of a -W worker process: reads "repo<TAB>etag<TAB>per-page<TAB>
+// generation" lines from stdin, fetches each with gh and answers with
+// "repo<TAB>generation<TAB>code<TAB>etag<TAB>remaining<TAB>reset<TAB>
+// retry-after<TAB>result" lines until stdin is closed.
+int worker_main(void) {
+  char line[512];
+  char *out = NULL;
+  size_t cap = 0;
+  while (fgets(line, sizeof(line), stdin)) {
+    line[strcspn(line, "\n")] = '\0';
+    char *etag = strchr(line, '\t');
+    if (etag)
+      *etag++ = '\0';
+    char *page = etag ? strchr(etag, '\t') : NULL;
+    if (page)
+      *page++ = '\0';
+    char *gen = page ? strchr(page, '\t') : NULL;
+    if (gen)
+      *gen++ = '\0';
+    if (!line[0])
+      continue;
+
+    int code = 0;
+    char new_etag[96] = "", text[FETCH_TEXT_MAX] = "";
+    RateLimit rl = {-1, 0, 0};
+    int fd;
+    pid_t pid = spawn_gh_fetch(line, etag ? etag : "",
+                               page ? atoi(page) : HISTORY_RUNS, &fd);
+    if (pid > 0) {
+      size_t len = 0;
+      ssize_t r;
+      do {
+        if (cap - len < 4096) {
+          char *grown = realloc(out, cap + 8192);
+          if (!grown)
+            break;
+          out = grown;
+          cap += 8192;
+        }
+        r = read(fd, out + len, cap - len - 1);
+        if (r > 0)
+          len += r;
+      } while (r > 0 || (r < 0 && errno == EINTR));
+      close(fd);
+      waitpid(pid, NULL, 0);
+      if (out) {
+        out[len] = '\0';
+        parse_gh_api_output(out, &code, new_etag, sizeof(new_etag), text,
+                            sizeof(text), &rl);
+      }
+    }
+    printf("%s\t%s\t%d\t%s\t%ld\t%ld\t%ld\t%s\n", line, gen ? gen : "0", code,
+           new_etag, rl.remaining, rl.reset, rl.retry_after, text);
+    fflush(stdout);
+  }
+  free(out);
+  return 0;
+}
+
+void worker_init(int count) {
+  num_workers = count < MAX_WORKERS ? count : MAX_WORKERS;
+  for (int k = 0; k < num_workers; k++) {
+    workers[k].pid = -1;
+    workers[k].in = workers[k].out = -1;
+    workers[k].repo = -1;
+  }
+}
+
+void worker_stop(Worker *w) {
+  if (w->in != -1)
+    close(w->in);
+  unwatch_fd(w->out);
+  if (w->out != -1)
+    close(w->out);
+  if (w->pid > 0) {
+    kill(w->pid, SIGTERM);
+    reap_child(w->pid);
+  }
+  w->pid = -1;
+  w->in = w->out = -1;
+  w->len = 0;
+}
+
+bool worker_start(Worker *w) {
+  char *argv[] = {"/proc/self/exe", "-W", NULL};
+  w->pid = spawn_piped(argv, &w->in, &w->out);
+  if (w->pid == -1) {
+    w->in = w->out = -1;
+    return false;
+  }
+  fcntl(w->out, F_SETFL, O_NONBLOCK);
+  watch_fd(w->out, EPOLLIN, WATCH_ENGINE, w - workers);
+  w->len = 0;
+  return true;
+}
+
+// Stores the result a worker reported for the named repo's fetch of
+// generation gen. Late results of cancelled or older fetches are dropped.
+bool worker_result(Worker *w, const char *name, uint32_t gen, int code,
+                   const char *etag, const char *text, const RateLimit *rl) {
+  int i = repo_lookup(name);
+  if (i < 0)
+    return false;
+  if (i == w->repo)
+    w->repo = -1;
+  if (!fetch_current(i, gen))
+    return false;
+  in_flight[i] = false;
+  return apply_fetch(i, code, etag, text, rl);
+}
+
+// Hands queued repos to idle workers, starting workers as needed.
+bool worker_pump(void) {
+  bool changed = false;
+  for (int k = 0; k < num_workers && fetch_qlen > 0; k++) {
+    Worker *w = &workers[k];
+    if (w->repo != -1)
+      continue;
+    if (w->pid == -1 && !worker_start(w))
+      break;
+    w->repo = fetch_dequeue();
+    const char *etag = fetch_etag(w->repo);
+    char line[400];
+    int n = snprintf(line, sizeof(line), "%s\t%s\t%d\t%u\n", REPOS[w->repo],
+                     etag, history_page(w->repo), fetch_gen[w->repo]);
+    if (n >= (int)sizeof(line) || write(w->in, line, n) != n) {
+      int i = w->repo;
+      worker_stop(w);
+      changed |= worker_result(w, REPOS[i], fetch_gen[i], 0, "", "", NULL);
+    }
+  }
+  return changed;
+}
+
+// Reads whatever worker w has written and routes complete lines by name.
+bool worker_io(Worker *w) {
+  bool changed = false;
+  if (w->out == -1)
+    return false;
+  for (;;) {
+    ssize_t n = read(w->out, w->line + w->len, sizeof(w->line) - w->len - 1);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break;
+    if (n <= 0) { // worker exited; fail its repo and respawn on demand
+      int i = w->repo;
+      worker_stop(w);
+      if (i != -1)
+        changed |= worker_result(w, REPOS[i], fetch_gen[i], 0, "", "", NULL);
+      break;
+    }
+    w->len += n;
+    w->line[w->len] = '\0';
+
+    char *nl;
+    while ((nl = strchr(w->line, '\n'))) {
+      *nl = '\0';
+      char *field[8] = {w->line};
+      int nf = 1;
+      for (char *p = w->line; nf < 8 && (p = strchr(p, '\t')); nf++) {
+        *p++ = '\0';
+        field[nf] = p;
+      }
+      if (nf == 8) {
+        RateLimit rl = {atol(field[4]), atol(field[5]), atol(field[6])};
+        changed |= worker_result(w, field[0], strtoul(field[1], NULL, 10),
+                                 atoi(field[2]), field[3], field[7], &rl);
+      }
+      w->len -= nl + 1 - w->line;
+      memmove(w->line, nl + 1, w->len + 1);
+    }
+    if (w->len == sizeof(w->line) - 1)
+      w->len = 0; // drop an oversized line
+  }
+  return worker_pump() || changed;
+}
+
+void worker_shutdown(void) {
+  for (int k = 0; k < num_workers; k++)
+    worker_stop(&workers[k]);
+}
+
+// ---- engine dispatch ----
+
+static int gh_running, gh_max = 1; // gh engine children running and allowed
+
+// Starts a gh engine fetch for repo i. Returns true if the child started.
+bool start_gh_fetch(int i) {
+  const char *etag = fetch_etag(i);
+  pid_t pid = spawn_gh_fetch(REPOS[i], etag, history_page(i), &pipes[i][0]);
+  if (pid <= 0)
+    return false;
+  fetch_pids[i] = pid;
+  fcntl(pipes[i][0], F_SETFL, O_NONBLOCK);
+  watch_fd(pipes[i][0], EPOLLIN, WATCH_GH, i);
+  return true;
+}
+
+// Starts gh children for queued repos while fewer than gh_max are running.
+// Returns true if a status changed.
+bool gh_pump(void) {
+  bool changed = false;
+  while (gh_running < gh_max && fetch_qlen > 0) {
+    int i = fetch_dequeue();
+    if (start_gh_fetch(i)) {
+      gh_running++;
+      continue;
+    }
+    in_flight[i] = false;
+    changed |= apply_fetch(i, 0, "", "", NULL);
+  }
+  return changed;
+}
+
+// Starts fetches for queued repos on the active engine.
+bool engine_pump(void) {
+  if (fetch_engine == ENGINE_HTTP)
+    return http_pump();
+  if (fetch_engine == ENGINE_WORKERS)
+    return worker_pump();
+  return gh_pump();
+}
+
+bool engine_io(int slot) {
+  if (fetch_engine == ENGINE_HTTP)
+    return http_io(&http_conns[slot]);
+  if (fetch_engine == ENGINE_WORKERS)
+    return worker_io(&workers[slot]);
+  return false;
+}
+
+// Reads the output of repo i's gh fetch and applies it once the pipe closes,
+// then starts the next queued fetch. Returns true if a status changed.
+bool gh_io(int i) {
+  if (pipes[i][0] == -1)
+    return false;
+  char buf[4096];
+  int n = read(pipes[i][0], buf, sizeof(buf));
+  if (n > 0) {
+    char *out = realloc(fetch_out[i], fetch_out_len[i] + n + 1);
+    if (out) {
+      memcpy(out + fetch_out_len[i], buf, n);
+      fetch_out_len[i] += n;
+      out[fetch_out_len[i]] = '\0';
+      fetch_out[i] = out;
+    }
+  } else if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+    unwatch_fd(pipes[i][0]);
+    close(pipes[i][0]);
+    reap_child(fetch_pids[i]);
+    pipes[i][0] = -1;
+    fetch_pids[i] = -1;
+    in_flight[i] = false;
+    gh_running--;
+
+    int code = 0;
+    char etag[96] = "", text[FETCH_TEXT_MAX] = "";
+    RateLimit rl = {-1, 0, 0};
+    if (fetch_out[i])
+      parse_gh_api_output(fetch_out[i], &code, etag, sizeof(etag), text,
+                          sizeof(text), &rl);
+    free(fetch_out[i]);
+    fetch_out[i] = NULL;
+    fetch_out_len[i] = 0;
+    bool changed = apply_fetch(i, code, etag, text, &rl);
+    return gh_pump() || changed;
+  }
+  return false;
+}
+
+// Fetches repo i outside of a full refresh. Returns true if a status changed.
+bool fetch_repo(int i) {
+  // retry at the poll interval if the fetch never reports back
+  schedule_at(i, now_ms() + sched_ceiling_s * 1000LL);
+  fetch_enqueue(i, false);
+  return engine_pump();
+}
+
+// Returns true if repo i has a fetch queued or running.
+bool fetch_pending(int i) {
+  return fetch_queued[i] || in_flight[i];
+}
+
+// Counts the fetches queued or running on the active engine.
+int fetches_busy(void) {
+  int busy = fetch_qlen + gh_running;
+  for (int k = 0; fetch_engine == ENGINE_HTTP && k < http_nconns; k++)
+    busy += http_conns[k].repo != -1;
+  for (int k = 0; fetch_engine == ENGINE_WORKERS && k < num_workers; k++)
+    busy += workers[k].repo != -1;
+  return busy;
+}
+
+// Abandons repo i's fetch once its child, worker or connection is gone; a
+// result that still turns up is dropped by fetch_current().
+void fetch_abandon(int i) {
+  in_flight[i] = false;
+  fetch_gen[i] = 0;
+  fetch_mark_us[i] = 0;
+}
+
+// Cancels fetches in flight for over FETCH_STALE_MS: gh children and workers
+// get SIGTERM and are reaped in the background, connections are closed. The
+// repos queue again at the front. Returns the number cancelled.
+int fetch_cancel_stale(void) {
+  long long cutoff = now_us() - FETCH_STALE_MS * 1000LL;
+  int cancelled = 0;
+  for (int i = 0; fetch_engine == ENGINE_GH && i < NUM_REPOS; i++) {
+    if (!in_flight[i] || fetch_pids[i] <= 0 || fetch_mark_us[i] > cutoff)
+      continue;
+    unwatch_fd(pipes[i][0]);
+    close(pipes[i][0]);
+    pipes[i][0] = -1;
+    kill(fetch_pids[i], SIGTERM);
+    reap_child(fetch_pids[i]);
+    fetch_pids[i] = -1;
+    free(fetch_out[i]);
+    fetch_out[i] = NULL;
+    fetch_out_len[i] = 0;
+    gh_running--;
+    fetch_abandon(i);
+    fetch_enqueue(i, true);
+    cancelled++;
+  }
+  for (int k = 0; fetch_engine == ENGINE_WORKERS && k < num_workers; k++) {
+    int i = workers[k].repo;
+    if (i == -1 || fetch_mark_us[i] > cutoff)
+      continue;
+    worker_stop(&workers[k]);
+    workers[k].repo = -1;
+    fetch_abandon(i);
+    fetch_enqueue(i, true);
+    cancelled++;
+  }
+  for (int k = 0; fetch_engine == ENGINE_HTTP && k < http_nconns; k++) {
+    int i = http_conns[k].repo;
+    if (i == -1 || fetch_mark_us[i] > cutoff)
+      continue;
+    http_close(&http_conns[k]);
+    http_conns[k].repo = -1;
+    fetch_abandon(i);
+    fetch_enqueue(i, true);
+    cancelled++;
+  }
+  return cancelled;
+}
+
+// Starts fetches for repos whose next poll is due, keeping at most max_busy
+// outstanding so polls go out as a steady stream and pacing them to the rate
+// limit budget. Returns true if a status changed.
+bool schedule_dispatch(int max_busy) {
+  delta_poll();
+  long long now = now_ms();
+  bool changed = false;
+  int busy = fetches_busy();
+  while (sched_len > 0 && busy < max_busy && next_due[sched_heap[0]] <= now) {
+    if (fetch_pending(sched_heap[0])) {
+      schedule_pop(); // its result reschedules it
+      continue;
+    }
+    if (!rate_limit_take())
+      break;
+    changed |= fetch_repo(schedule_pop());
+    busy++;
+  }
+  return changed;
+}
+
+// Returns the ms until the next scheduled poll, or -1 if none is queued.
+long long schedule_wait_ms(void) {
+  if (sched_len == 0)
+    return -1;
+  long long wait = next_due[sched_heap[0]] - now_ms();
+  return wait > 0 ? wait : 0;
+}
+
+// Returns the ms until schedule_dispatch() can next start a fetch, or -1 if
+// only a finishing fetch can make room.
+long long dispatch_wait_ms(int max_busy) {
+  long long wait = schedule_wait_ms();
+  if (wait == 0) // due repos left over wait on a slot or the budget
+    wait = fetches_busy() >= max_busy ? -1 : rate_limit_delay_ms() + 1;
+  long long delta = delta_wait_ms();
+  if (delta >= 0 && (wait < 0 || delta < wait))
+    wait = delta;
+  return wait;
+}
+
+// ---- background discovery ----
+
+typedef struct {
+  const char *user;
+  pid_t pid;
+  int fd;    // -1 once the listing has been read
+  int pidfd; // watched from then until gh exits
+  char line[512];
+  size_t len;
+  bool ok;
+  int listed, pushed; // repos listed and found pushed by a delta pass
+  bool full;          // the last delta pass may have missed pushed repos
+} Discovery;
+
+static Discovery *discovery;
+static int num_discovery, discovery_pending;
+static int discovery_next;     // next user whose listing has not started
+static int discovery_running;  // listings started and not yet finished
+static int discovery_max = 1;  // listings allowed to run at once
+static bool discovery_delta;   // the listings are a delta pass
+static long long delta_due;    // ms timestamp of the next delta pass
+static int delta_interval_s;   // seconds between delta passes
+
+// Starts listings for waiting users while fewer than discovery_max run.
+static void discovery_launch(void) {
+  while (discovery_running < discovery_max && discovery_next < num_discovery) {
+    int u = discovery_next++;
+    Discovery *d = &discovery[u];
+    bool all = !discovery_delta || d->full;
+    d->pid = spawn_repo_list(d->user, all ? REPO_LIST_LIMIT : DELTA_LIST_LIMIT,
+                             &d->fd);
+    if (d->pid == -1) {
+      d->fd = -1;
+      discovery_pending--;
+      continue;
+    }
+    fcntl(d->fd, F_SETFL, O_NONBLOCK);
+    watch_fd(d->fd, EPOLLIN, WATCH_DISCOVERY, u);
+    discovery_running++;
+  }
+}
+
+// Lists every user's repos, up to max_running at a time, reading them as the
+// event loop reports output. Repos join the dashboard as they are listed, so
+// the first page of any owner is on screen and fetching while the rest of
+// the listings stream in.
+void discovery_start(char **users, int count, int max_running) {
+  discovery = calloc(count, sizeof(*discovery));
+  if (!discovery)
+    return;
+  num_discovery = discovery_pending = count;
+  discovery_max = max_running > 0 ? max_running : 1;
+  delta_due = now_ms() + delta_interval_s * 1000LL;
+  for (int u = 0; u < count; u++) {
+    discovery[u].user = users[u];
+    discovery[u].fd = discovery[u].pidfd = -1;
+  }
+  discovery_launch();
+  if (discovery_pending == 0)
+    discovery_complete = false;
+}
+
+// Records how d's listing ended once its output has been read and gh has
+// exited; until then it is retried when gh's pidfd becomes readable.
+void discovery_finish(Discovery *d) {
+  int status;
+  if (d->fd != -1 || d->pid <= 0)
+    return;
+  pid_t done = waitpid(d->pid, &status, WNOHANG);
+  if (done == 0 && d->pidfd == -1)
+    d->pidfd = child_watch(d->pid, WATCH_LISTING, (int)(d - discovery));
+  if (done == 0 && d->pidfd == -1)
+    done = waitpid(d->pid, &status, 0);
+  if (done == 0)
+    return;
+  if (d->pidfd != -1) {
+    unwatch_fd(d->pidfd);
+    close(d->pidfd);
+    d->pidfd = -1;
+  }
+  d->ok = done > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  d->pid = -1;
+  if (discovery_delta) {
+    // every repo on the page was pushed: more may be past it, so the next
+    // pass lists this owner in full
+    d->full = d->ok && d->listed == atoi(DELTA_LIST_LIMIT) &&
+              d->pushed == d->listed;
+    discovery_pending--;
+    return;
+  }
+  if (--discovery_pending == 0) {
+    discovery_complete = true;
+    for (int u = 0; u < num_discovery; u++)
+      discovery_complete &= discovery[u].ok;
+    snapshot_dirty = true;
+  }
+}
+
+// Handles one "name<TAB>default branch<TAB>pushedAt" line of d's listing. A
+// repo not seen before is added and its first fetch queued; one pushed since
+// the previous listing is polled now and from a short interval again.
+// Returns true if the repo table changed.
+bool discovery_line(Discovery *d, char *line) {
+  char *branch = strchr(line, '\t');
+  if (branch)
+    *branch++ = '\0';
+  char *pushed = branch ? strchr(branch, '\t') : NULL;
+  if (pushed)
+    *pushed++ = '\0';
+  if (!line[0])
+    return false;
+  bool changed = false;
+  d->listed++;
+  int i = repo_lookup(line);
+  if (i < 0 && (i = repo_add(line)) >= 0) {
+    etag_adopt(i);
+    mark_loading(i);
+    schedule_at(i, now_ms()); // dispatched under the -c limit
+    d->pushed++;
+    changed = true;
+  }
+  if (i < 0)
+    return changed;
+  discovered[i] = true;
+  if (branch && *branch)
+    default_branch[i] = branch_intern(branch);
+  long long t = pushed ? iso_time(pushed) : 0;
+  if (t > pushed_at[i]) {
+    if (pushed_at[i] && sched_delta) {
+      poll_backoff_s[i] = 0;
+      if (!fetch_pending(i))
+        schedule_at(i, now_ms());
+      d->pushed++;
+    }
+    pushed_at[i] = t;
+  }
+  return changed;
+}
+
+// Reads listing output from d. Returns true if the repo table changed.
+bool discovery_io(Discovery *d) {
+  bool changed = false;
+  if (d->fd == -1)
+    return false;
+  for (;;) {
+    ssize_t n = read(d->fd, d->line + d->len, sizeof(d->line) - d->len - 1);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return changed;
+    if (n <= 0)
+      break;
+    d->len += n;
+    d->line[d->len] = '\0';
+
+    char *nl;
+    while ((nl = strchr(d->line, '\n'))) {
+      *nl = '\0';
+      changed |= discovery_line(d, d->line);
+      d->len -= nl + 1 - d->line;
+      memmove(d->line, nl + 1, d->len + 1);
+    }
+    if (d->len == sizeof(d->line) - 1)
+      d->len = 0; // drop an oversized line
+  }
+
+  unwatch_fd(d->fd);
+  close(d->fd);
+  d->fd = -1;
+  discovery_running--;
+  discovery_launch();
+  discovery_finish(d);
+  return changed;
+}
+
+// Starts a delta pass of --delta once one is due: each owner's most recently
+// pushed repos are listed again, one request per owner, and those pushed
+// since the previous listing are polled at once. Idle repos otherwise wait
+// for the slow sweep.
+void delta_poll(void) {
+  if (!sched_delta || discovery_pending > 0 || now_ms() < delta_due)
+    return;
+  delta_due = now_ms() + delta_interval_s * 1000LL;
+  discovery_delta = true;
+  for (int u = 0; u < num_discovery; u++) {
+    Discovery *d = &discovery[u];
+    d->len = 0;
+    d->listed = d->pushed = 0;
+  }
+  discovery_next = 0;
+  discovery_pending = num_discovery;
+  discovery_launch();
+}
+
+// Returns the ms until the next delta pass, or -1 if none is coming.
+long long delta_wait_ms(void) {
+  if (!sched_delta || discovery_pending > 0 || num_discovery == 0)
+    return -1;
+  long long wait = delta_due - now_ms();
+  return wait > 0 ? wait : 0;
+}
+
+void discovery_shutdown(void) {
+  for (int u = 0; u < num_discovery; u++) {
+    Discovery *d = &discovery[u];
+    if (d->fd != -1)
+      close(d->fd);
+    if (d->pidfd != -1)
+      close(d->pidfd);
+    if (d->pid > 0) {
+      kill(d->pid, SIGTERM);
+      waitpid(d->pid, NULL, 0);
+    }
+  }
+  free(discovery);
+  discovery = NULL;
+  num_discovery = 0;
+}
+
+void spawn_fetches(void) {
+  save_etags(); // persist what the previous cycle learned
+
+  // a refresh still under way absorbs this one: its queued repos keep their
+  // place, those it already answered are not fetched again and none of them
+  // is rescheduled
+  if (refresh_left > 0 && fetches_busy() > 0) {
+    fetch_cancel_stale();
+    engine_pump();
+    return;
+  }
+
+  long long now = now_ms();
+  long wait_s = rate_limit_wait_s();
+  if (wait_s > 0) { // out of budget: refresh as soon as it resets instead
+    for (int i = 0; i < NUM_REPOS; i++) {
+      if (!fetch_pending(i))
+        schedule_at(i, now + (wait_s + 1) * 1000LL);
+    }
+    return;
+  }
+
+  // fetches already in flight count towards the new generation rather than
+  // starting over, unless they are stale, and their results reschedule them.
+  // The rest queue behind them while the rate limit budget lasts and are
+  // left to schedule_dispatch() after.
+  fetch_generation++;
+  fetch_clear_queue();
+  fetch_cancel_stale();
+  long long fallback = now + sched_ceiling_s * 1000LL; // if it never reports
+  for (int i = 0; i < NUM_REPOS; i++) {
+    mark_loading(i);
+    refresh_owed[i] = true;
+    if (fetch_pending(i))
+      continue;
+    if (rate_limit_take()) {
+      fetch_enqueue(i, false);
+      schedule_at(i, fallback);
+    } else {
+      schedule_at(i, now);
+    }
+  }
+  refresh_left = NUM_REPOS;
+  engine_pump();
+}
+
+// ---- webhook listener ----
+//
+// `--listen [host:]port` accepts GitHub workflow_run and workflow_job
+// deliveries over plain HTTP (from a relay or a reverse proxy) and applies
+// them as they arrive. With GHSTATUS_WEBHOOK_SECRET set, deliveries must
+// carry a matching X-Hub-Signature-256.
+
+#define HOOK_MAX_CONNS 256       // deliveries read at once
+#define HOOK_MAX_REQUEST (4 << 20) // headers and payload
+
+typedef struct {
+  int fd; // -1 when the slot is free
+  char *buf;
+  size_t len, cap;
+} HookConn;
+
+static int hook_fd = -1;
+static HookConn hook_conns[HOOK_MAX_CONNS];
+static const char *hook_secret;
+static bool hook_paused; // every slot busy: the listener is not watched
+
+// Finds header name in the header block head and copies its value to buf.
+static bool hook_header(const char *head, const char *name, char *buf,
+                        size_t len) {
+  size_t nlen = strlen(name);
+  for (const char *p = strstr(head, "\r\n"); p; p = strstr(p, "\r\n")) {
+    p += 2;
+    if (strncasecmp(p, name, nlen) == 0 && p[nlen] == ':') {
+      const char *v = p + nlen + 1;
+      v += strspn(v, " \t");
+      snprintf(buf, len, "%.*s", (int)strcspn(v, "\r\n"), v);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Checks the X-Hub-Signature-256 value sig against body.
+bool hook_signature_ok(const char *secret, const char *body, size_t len,
+                       const char *sig) {
+  unsigned char md[EVP_MAX_MD_SIZE];
+  unsigned int mdlen = 0;
+  if (strncmp(sig, "sha256=", 7) != 0 ||
+      !HMAC(EVP_sha256(), secret, (int)strlen(secret),
+            (const unsigned char *)body, len, md, &mdlen))
+    return false;
+  char hex[2 * EVP_MAX_MD_SIZE + 1];
+  for (unsigned int k = 0; k < mdlen; k++)
+    sprintf(hex + 2 * k, "%02x", md[k]);
+  return strlen(sig + 7) == 2 * mdlen &&
+         CRYPTO_memcmp(hex, sig + 7, 2 * mdlen) == 0;
+}
+
+// Applies one delivery. Returns the HTTP status to answer with.
+int hook_deliver(const char *event, const char *body, size_t len) {
+  char repo[256], text[160], status[64];
+  int rc = parse_webhook(event, body, len, repo, sizeof(repo), text,
+                         sizeof(text));
+  if (rc < 0)
+    return 400;
+  int i = rc > 0 ? repo_lookup(repo) : -1;
+  if (i < 0)
+    return 202; // not an event or a repo this dashboard shows
+  if (rc == 1 && !workflow_mode) {
+    if (history_apply(i, split_runs(text, status, sizeof(status))))
+      mark_dirty(i);
+    set_status(i, status);
+  } else if (!fetch_pending(i))
+    schedule_at(i, now_ms()); // fetch the run, or every workflow's latest
+  return 202;
+}
+
+static void hook_close(int k) {
+  HookConn *c = &hook_conns[k];
+  unwatch_fd(c->fd);
+  close(c->fd);
+  free(c->buf);
+  *c = (HookConn){.fd = -1};
+  if (hook_paused) {
+    watch_fd(hook_fd, EPOLLIN, WATCH_HOOK_LISTEN, 0);
+    hook_paused = false;
+  }
+}
+
+static void hook_reply(int k, int code) {
+  char resp[96];
+  int n = snprintf(resp, sizeof(resp),
+                   "HTTP/1.1 %d %s\r\nContent-Length: 0\r\n"
+                   "Connection: close\r\n\r\n",
+                   code, code < 300 ? "Accepted" : "Rejected");
+  send(hook_conns[k].fd, resp, n, MSG_NOSIGNAL);
+  hook_close(k);
+}
+
+// Opens the webhook listener on spec, "port" or "host:port". Without a host
+// it listens on the loopback interface only.
+int hook_listen(const char *spec) {
+  char host[256] = "127.0.0.1";
+  const char *port = spec, *colon = strrchr(spec, ':');
+  if (colon) {
+    snprintf(host, sizeof(host), "%.*s", (int)(colon - spec), spec);
+    port = colon + 1;
+  }
+  struct addrinfo hints = {.ai_family = AF_UNSPEC,
+                           .ai_socktype = SOCK_STREAM,
+                           .ai_flags = AI_PASSIVE},
+                  *res;
+  if (getaddrinfo(host[0] ? host : NULL, port, &hints, &res) != 0) {
+    fprintf(stderr, "Cannot listen on '%s'.\n", spec);
+    return -1;
+  }
+  hook_fd = socket(res->ai_family, res->ai_socktype | SOCK_NONBLOCK |
+                                       SOCK_CLOEXEC, 0);
+  int one = 1;
+  if (hook_fd != -1)
+    setsockopt(hook_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  if (hook_fd == -1 || bind(hook_fd, res->ai_addr, res->ai_addrlen) == -1 ||
+      listen(hook_fd, 128) == -1) {
+    perror(spec);
+    freeaddrinfo(res);
+    return -1;
+  }
+  freeaddrinfo(res);
+  for (int k = 0; k < HOOK_MAX_CONNS; k++)
+    hook_conns[k].fd = -1;
+  hook_secret = getenv("GHSTATUS_WEBHOOK_SECRET");
+  if (hook_secret && !*hook_secret)
+    hook_secret = NULL;
+  watch_fd(hook_fd, EPOLLIN, WATCH_HOOK_LISTEN, 0);
+  return 0;
+}
+
+// Accepts waiting deliveries into free slots. Once every slot is busy the
+// rest wait in the backlog until one closes.
+void hook_accept(void) {
+  for (int k = 0; k < HOOK_MAX_CONNS; k++) {
+    if (hook_conns[k].fd != -1)
+      continue;
+    int fd = accept4(hook_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd == -1)
+      return;
+    hook_conns[k].fd = fd;
+    watch_fd(fd, EPOLLIN, WATCH_HOOK, k);
+  }
+  watch_fd(hook_fd, 0, WATCH_HOOK_LISTEN, 0);
+  hook_paused = true;
+}
+
+// Reads from delivery k and handles it once its payload is complete.
+void hook_io(int k) {
+  HookConn *c = &hook_conns[k];
+  for (;;) {
+    if (c->len + 4096 + 1 > c->cap) {
+      size_t cap = c->cap ? c->cap * 2 : 16384;
+      char *buf = cap <= HOOK_MAX_REQUEST ? realloc(c->buf, cap) : NULL;
+      if (!buf) {
+        hook_reply(k, 413);
+        return;
+      }
+      c->buf = buf;
+      c->cap = cap;
+    }
+    ssize_t n = read(c->fd, c->buf + c->len, c->cap - c->len - 1);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break;
+    if (n <= 0) {
+      hook_close(k);
+      return;
+    }
+    c->len += n;
+  }
+  c->buf[c->len] = '\0';
+
+  char *end = strstr(c->buf, "\r\n\r\n");
+  if (!end)
+    return; // headers still arriving
+  *end = '\0';
+  char value[128], event[64] = "", sig[128] = "";
+  size_t body_len = hook_header(c->buf, "Content-Length", value,
+                                sizeof(value))
+                        ? strtoul(value, NULL, 10)
+                        : 0;
+  char *body = end + 4;
+  if ((size_t)(c->buf + c->len - body) < body_len) {
+    *end = '\r'; // payload still arriving
+    return;
+  }
+  if (strncmp(c->buf, "POST ", 5) != 0) {
+    hook_reply(k, 405);
+    return;
+  }
+  hook_header(c->buf, "X-GitHub-Event", event, sizeof(event));
+  hook_header(c->buf, "X-Hub-Signature-256", sig, sizeof(sig));
+  if (hook_secret && !hook_signature_ok(hook_secret, body, body_len, sig)) {
+    hook_reply(k, 401);
+    return;
+  }
+  hook_reply(k, hook_deliver(event, body, body_len));
+}
+
+void hook_shutdown(void) {
+  for (int k = 0; hook_fd != -1 && k < HOOK_MAX_CONNS; k++) {
+    if (hook_conns[k].fd != -1)
+      hook_close(k);
+  }
+  if (hook_fd != -1)
+    close(hook_fd);
+  hook_fd = -1;
+}
 
-int ORIGINAL_INDEX[MAX_REPOS]; // for restoring original order
-int order[MAX_REPOS];          // active display order
+// ---- shared daemon ----
+//
+// `--daemon` runs discovery and fetching with no UI and publishes the repo
+// table over a Unix socket; `--attach` runs the UI against it. The daemon
+// sends one line per message:
+//   H <users>                              on connect
+//   R <stale> <repo> <status>              a repo was added or changed
+//   P <busy> <next poll> <budget> <blocked until>   fetch and budget state
+//   W <repo> <workflows>                   with --workflows, after its R line
+// with tab-separated fields. The workflows are workflow_text with ';' in
+// place of newlines, which neither run texts nor workflow names contain.
+// Clients send "refresh" to start a full refresh.
 
-int pipes[MAX_REPOS][2];
-pid_t fetch_pids[MAX_REPOS];
+#define DAEMON_SOCKET "daemon.sock"      // under the cache directory
+#define DAEMON_MAX_PENDING (64 << 20)    // queued output before a client drops
+#define DAEMON_LINE_MAX (WORKFLOWS_MAX * 96 + 512) // longest line, a W line
 
-// button hover state
-int hover_x = -1, hover_y = -1;
+typedef struct {
+  int fd;
+  char *out; // output not yet accepted by the socket
+  size_t out_len, out_off;
+  char in[64];
+  size_t in_len;
+  bool dead;
+} DaemonClient;
 
-void apply_sort(void);
+static int daemon_fd = -1; // listening socket
+static DaemonClient *clients;
+static int num_clients, clients_cap;
+static int num_users; // users the dashboard lists, reported by the daemon
+static time_t last_refresh;
+static char daemon_state[96]; // last P line sent
 
-void load_repos(const char *user) {
-  int fds[2];
-  if (pipe(fds) == -1)
-    return;
+static int attach_fd = -1; // connection to the daemon in --attach mode
+static char attach_in[DAEMON_LINE_MAX];
+static size_t attach_len;
+static bool remote_busy;
+static long long remote_next_poll = -1; // CLOCK_MONOTONIC ms, -1 if none
 
-  pid_t pid = fork();
-  if (pid == -1) {
-    close(fds[0]);
-    close(fds[1]);
-    fprintf(stderr, "Failed to fork 'gh'. GitHub CLI is required.\n");
-    return;
+// Resolves the daemon socket: path if given, else one in the cache dir.
+int daemon_socket_path(const char *path, struct sockaddr_un *addr) {
+  char buf[PATH_MAX];
+  if (!path) {
+    if (cache_path(DAEMON_SOCKET, buf, sizeof(buf)) != 0)
+      return -1;
+    path = buf;
   }
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(addr->sun_path))
+    return -1;
+  strcpy(addr->sun_path, path);
+  return 0;
+}
 
-  if (pid == 0) { // child
-    dup2(fds[1], STDOUT_FILENO);
-    close(fds[0]);
-    close(fds[1]);
+// Formats repo i as an R line into buf. Returns its length.
+int daemon_repo_line(int i, char *buf, size_t len) {
+  int n = snprintf(buf, len, "R\t%d\t%s\t%s\n", status_stale[i], REPOS[i],
+                   repo_status(i));
+  return n < (int)len ? n : (int)len - 1;
+}
 
-    int err = dup(STDERR_FILENO);
-    int devnull = open("/dev/null", O_WRONLY);
-    if (devnull >= 0) {
-      dup2(devnull, STDERR_FILENO);
-      close(devnull);
-    }
+// Formats repo i's workflows as a W line into buf. Returns its length, 0 if
+// it has none.
+int daemon_workflow_line(int i, char *buf, size_t len) {
+  if (!workflow_text[i])
+    return 0;
+  int n = snprintf(buf, len, "W\t%s\t%s", REPOS[i], workflow_text[i]);
+  if (n >= (int)len)
+    n = (int)len - 1;
+  if (n > 0 && buf[n - 1] == '\n')
+    n--; // the last workflow's newline ends the line
+  for (int k = 2 + strlen(REPOS[i]); k < n; k++) {
+    if (buf[k] == '\n')
+      buf[k] = ';';
+  }
+  buf[n++] = '\n';
+  return n;
+}
 
-    execlp("gh", "gh", "repo", "list", user, "--visibility", "all",
-           "--limit", "500",
-           "--json", "nameWithOwner", "--jq", ".[].nameWithOwner",
-           (char *)NULL);
-    if (err != -1) {
-      dup2(err, STDERR_FILENO);
-      close(err);
-    }
-    fprintf(stderr, "Failed to execute 'gh'. GitHub CLI is required.\n");
-    _exit(1); // exec failed
+static void client_watch(int k) {
+  DaemonClient *c = &clients[k];
+  uint32_t events = EPOLLIN;
+  if (c->out_off < c->out_len)
+    events |= EPOLLOUT;
+  watch_fd(c->fd, events, WATCH_CLIENT, k);
+}
+
+// Writes as much of c's pending output as the socket takes.
+static void client_flush(DaemonClient *c) {
+  while (!c->dead && c->out_off < c->out_len) {
+    ssize_t n = send(c->fd, c->out + c->out_off, c->out_len - c->out_off,
+                     MSG_NOSIGNAL);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return;
+    if (n <= 0)
+      c->dead = true;
+    else
+      c->out_off += n;
   }
+  c->out_off = c->out_len = 0;
+}
 
-  close(fds[1]);
-  FILE *fp = fdopen(fds[0], "r");
-  if (!fp) {
-    close(fds[0]);
-    waitpid(pid, NULL, 0);
+// Queues len bytes for client c; a client too far behind is dropped.
+void client_send(DaemonClient *c, const char *data, size_t len) {
+  if (c->dead)
+    return;
+  if (c->out_len + len > DAEMON_MAX_PENDING) {
+    c->dead = true;
     return;
   }
-
-  int old_num = NUM_REPOS;
-  char line[256];
-  while (fgets(line, sizeof(line), fp) && NUM_REPOS < MAX_REPOS) {
-    line[strcspn(line, "\n")] = 0;
-    char *copy = strdup(line);
-    if (!copy) {
-      // allocation failed; roll back any repos added in this call
-      fprintf(stderr, "Failed to allocate repo name\n");
-      while (NUM_REPOS > old_num) {
-        free(REPOS[--NUM_REPOS]);
-      }
-      break; // stop reading further repositories
-    }
-    REPOS[NUM_REPOS++] = copy;
+  char *out = realloc(c->out, c->out_len + len);
+  if (!out) {
+    c->dead = true;
+    return;
   }
-  fclose(fp);
+  memcpy(out + c->out_len, data, len);
+  c->out = out;
+  c->out_len += len;
+}
 
-  int status;
-  if (waitpid(pid, &status, 0) == -1 || !WIFEXITED(status) ||
-      WEXITSTATUS(status) != 0) {
-    while (NUM_REPOS > old_num) {
-      free(REPOS[--NUM_REPOS]);
-    }
-  }
+static void clients_broadcast(const char *data, size_t len) {
+  for (int k = 0; k < num_clients; k++)
+    client_send(&clients[k], data, len);
 }
 
-const StatusEntry *status_details(const char *status) {
-  for (size_t i = 0; i < STATUS_KNOWN; i++) {
-    if (status && strstr(status, status_map[i].match))
-      return &status_map[i];
+// Queues repo i's R line, and its W line if it has one, for client c or, if
+// c is NULL, every client.
+void daemon_send_repo(DaemonClient *c, int i) {
+  char line[DAEMON_LINE_MAX];
+  for (int w = 0; w < 2; w++) {
+    int n = w ? daemon_workflow_line(i, line, sizeof(line))
+              : daemon_repo_line(i, line, sizeof(line));
+    if (n > 0 && c)
+      client_send(c, line, n);
+    else if (n > 0)
+      clients_broadcast(line, n);
   }
-  return &status_map[STATUS_KNOWN];
 }
 
-const wchar_t *status_icon(const char *status) {
-  return status_details(status)->icon;
+// Closes clients that hung up or fell behind, then flushes the rest.
+static void clients_sweep(void) {
+  for (int k = 0; k < num_clients; k++)
+    client_flush(&clients[k]);
+  for (int k = 0; k < num_clients;) {
+    DaemonClient *c = &clients[k];
+    if (!c->dead) {
+      client_watch(k++);
+      continue;
+    }
+    unwatch_fd(c->fd);
+    close(c->fd);
+    free(c->out);
+    *c = clients[--num_clients];
+  }
 }
 
-int status_color(const char *status) {
-  return status_details(status)->color;
+// Binds the daemon socket, refusing to replace one a daemon still answers.
+int daemon_listen(const char *path) {
+  struct sockaddr_un addr;
+  if (daemon_socket_path(path, &addr) != 0) {
+    fprintf(stderr, "No usable path for the daemon socket.\n");
+    return -1;
+  }
+  int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (probe != -1 &&
+      connect(probe, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+    fprintf(stderr, "A daemon is already listening on %s.\n", addr.sun_path);
+    close(probe);
+    return -1;
+  }
+  if (probe != -1)
+    close(probe);
+  unlink(addr.sun_path);
+
+  daemon_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (daemon_fd == -1 ||
+      bind(daemon_fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 ||
+      listen(daemon_fd, 16) == -1) {
+    perror(addr.sun_path);
+    return -1;
+  }
+  watch_fd(daemon_fd, EPOLLIN, WATCH_LISTEN, 0);
+  return 0;
 }
 
-void describe_status(const char *status, const char *fallback, char *buf,
-                     size_t len) {
-  if (!buf || len == 0)
-    return;
-  if (status && *status) {
-    size_t bi = 0;
-    for (const char *p = status; *p && bi + 1 < len; ++p) {
-      char ch = (*p == '_') ? ' ' : *p;
-      buf[bi++] = ch;
+// Accepts waiting clients and queues the whole table for each.
+void daemon_accept(void) {
+  int fd;
+  while ((fd = accept4(daemon_fd, NULL, NULL,
+                       SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+    if (num_clients == clients_cap) {
+      int cap = clients_cap ? clients_cap * 2 : 16;
+      DaemonClient *grown = realloc(clients, cap * sizeof(*grown));
+      if (!grown) {
+        close(fd);
+        continue;
+      }
+      clients = grown;
+      clients_cap = cap;
     }
-    buf[bi] = '\0';
-    if (bi > 0)
-      return;
-  }
-  if (fallback) {
-    snprintf(buf, len, "%s", fallback);
-  } else {
-    buf[0] = '\0';
+    DaemonClient *c = &clients[num_clients++];
+    *c = (DaemonClient){.fd = fd};
+    char line[512];
+    int n = snprintf(line, sizeof(line), "H\t%d\n", num_users);
+    client_send(c, line, n);
+    for (int i = 0; i < NUM_REPOS; i++)
+      daemon_send_repo(c, i);
+    client_send(c, daemon_state, strlen(daemon_state));
   }
 }
 
-void spawn_fetches(int pipes[][2], pid_t pids[], int max_concurrent_fetches) {
-  // tear down any previous fetches
-  bool status_changed = false;
-  for (int i = 0; i < NUM_REPOS; i++) {
-    if (pipes[i][0] != -1) {
-      close(pipes[i][0]);
-      pipes[i][0] = -1;
-    }
-    if (pipes[i][1] != -1) {
-      close(pipes[i][1]);
-      pipes[i][1] = -1;
+// Reads commands from client k.
+void client_io(int k) {
+  DaemonClient *c = &clients[k];
+  for (;;) {
+    ssize_t n = read(c->fd, c->in + c->in_len, sizeof(c->in) - c->in_len - 1);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return;
+    if (n <= 0) {
+      c->dead = true;
+      return;
     }
-    if (pids[i] > 0) {
-      waitpid(pids[i], NULL, 0);
-      pids[i] = -1;
+    c->in_len += n;
+    c->in[c->in_len] = '\0';
+    char *nl;
+    while ((nl = strchr(c->in, '\n'))) {
+      *nl = '\0';
+      if (strcmp(c->in, "refresh") == 0 && time(NULL) - last_refresh >= 1) {
+        spawn_fetches();
+        last_refresh = time(NULL);
+      }
+      c->in_len -= nl + 1 - c->in;
+      memmove(c->in, nl + 1, c->in_len + 1);
     }
+    if (c->in_len == sizeof(c->in) - 1)
+      c->in_len = 0; // drop an oversized line
   }
+}
 
-  int running = 0; // currently active children
+// Sends clients every repo changed since the last call and the fetch state
+// if it moved.
+void daemon_publish(void) {
   for (int i = 0; i < NUM_REPOS; i++) {
-    while (running >= max_concurrent_fetches) {
-      int status;
-      pid_t done = wait(&status);
-      if (done <= 0)
+    if (!repo_dirty[i])
+      continue;
+    repo_dirty[i] = false;
+    daemon_send_repo(NULL, i);
+  }
+  char state[sizeof(daemon_state)];
+  long long wait_ms = schedule_wait_ms();
+  int n = snprintf(state, sizeof(state), "P\t%d\t%lld\t%ld\t%lld\n",
+                   discovery_pending > 0 || fetches_busy() > 0,
+                   wait_ms >= 0 ? now_ms() + wait_ms : -1, rate_remaining,
+                   (long long)rate_blocked_until);
+  if (strcmp(state, daemon_state) != 0) {
+    clients_broadcast(state, n);
+    strcpy(daemon_state, state);
+  }
+  clients_sweep();
+}
+
+// Serves clients until SIGINT or SIGTERM; the fetch pipeline is already
+// running.
+int daemon_main(int sig_fd, int max_concurrent_fetches) {
+  int timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  long long timer_at = -1;
+  watch_fd(timer, EPOLLIN, WATCH_TIMER, 0);
+  time_t last_snapshot = time(NULL);
+  bool quit = false;
+  while (!quit) {
+    schedule_dispatch(max_concurrent_fetches);
+    daemon_publish();
+    long long poll_ms = dispatch_wait_ms(max_concurrent_fetches);
+    long long wake = poll_ms >= 0 ? now_ms() + poll_ms : -1;
+    long long dump_at = telemetry_dump();
+    if (dump_at >= 0 && (wake < 0 || dump_at < wake))
+      wake = dump_at;
+    timer_arm(timer, &timer_at, wake);
+
+    struct epoll_event events[64];
+    int nev = epoll_wait(loop_fd, events, 64, -1);
+    for (int e = 0; e < nev; e++) {
+      int index = (int)(uint32_t)events[e].data.u64;
+      switch ((WatchKind)(events[e].data.u64 >> 32)) {
+      case WATCH_GH:
+        gh_io(index);
         break;
-      running--;
-      for (int j = 0; j < NUM_REPOS; j++) {
-        if (pids[j] == done) {
-          pids[j] = -1;
-          break;
+      case WATCH_ENGINE:
+        engine_io(index);
+        break;
+      case WATCH_DISCOVERY:
+        discovery_io(&discovery[index]);
+        break;
+      case WATCH_TIMER: {
+        uint64_t expirations;
+        if (read(timer, &expirations, sizeof(expirations)) > 0)
+          timer_at = -1;
+        break;
+      }
+      case WATCH_SIGNAL: {
+        struct signalfd_siginfo si;
+        while (read(sig_fd, &si, sizeof(si)) == sizeof(si)) {
+          if (si.ssi_signo == SIGINT || si.ssi_signo == SIGTERM)
+            quit = true;
         }
+        break;
+      }
+      case WATCH_CHILD:
+        reap_io(index);
+        break;
+      case WATCH_LISTING:
+        discovery_finish(&discovery[index]);
+        break;
+      case WATCH_LISTEN:
+        daemon_accept();
+        break;
+      case WATCH_HOOK_LISTEN:
+        hook_accept();
+        break;
+      case WATCH_HOOK:
+        hook_io(index);
+        break;
+      case WATCH_CLIENT:
+        if (events[e].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+          client_io(index);
+        break;
+      default:
+        break;
       }
     }
 
-    if (pipe(pipes[i]) == -1) {
-      pipes[i][0] = pipes[i][1] = -1;
-      continue;
+    if (snapshot_dirty && time(NULL) - last_snapshot >= SNAPSHOT_INTERVAL_S) {
+      save_snapshot();
+      last_snapshot = time(NULL);
     }
+  }
 
-    pid_t pid = fork();
-    if (pid == 0) {
-      dup2(pipes[i][1], STDOUT_FILENO);
-      close(pipes[i][0]);
-      close(pipes[i][1]);
-      int err = dup(STDERR_FILENO);
-      int devnull = open("/dev/null", O_WRONLY);
-      if (devnull >= 0) {
-        dup2(devnull, STDERR_FILENO);
-        close(devnull);
-      }
-
-      execlp("gh", "gh", "run", "list", "-L", "1", "-R", REPOS[i], "--json",
-             "status,conclusion", "--jq",
-             ".[0] | \"\\(.status) \\(.conclusion)\"", (char *)NULL);
-      if (err != -1) {
-        dup2(err, STDERR_FILENO);
-        close(err);
-      }
-      fprintf(stderr, "Failed to execute 'gh'. GitHub CLI is required.\n");
-      _exit(1);
-    } else if (pid > 0) {
-      pids[i] = pid;
-      close(pipes[i][1]);
-      fcntl(pipes[i][0], F_SETFL, O_NONBLOCK);
+  for (int k = 0; k < num_clients; k++)
+    clients[k].dead = true;
+  clients_sweep();
+  free(clients);
+  struct sockaddr_un addr;
+  socklen_t len = sizeof(addr);
+  if (getsockname(daemon_fd, (struct sockaddr *)&addr, &len) == 0)
+    unlink(addr.sun_path);
+  close(daemon_fd);
+  close(timer);
+  return 0;
+}
 
-      if (strcmp(STATUS[i], "loading") != 0) {
-        strcpy(STATUS[i], "loading");
-        status_changed = true;
-        status_received[i] = 0;
-      }
-      status_buf[i][0] = '\0';
-      running++;
-    } else {
-      fprintf(stderr, "Failed to fork 'gh'. GitHub CLI is required.\n");
-      close(pipes[i][0]);
-      close(pipes[i][1]);
-      pipes[i][0] = pipes[i][1] = -1;
+// Connects to the daemon for --attach. Returns 0 on success.
+int attach_start(const char *path) {
+  struct sockaddr_un addr;
+  if (daemon_socket_path(path, &addr) != 0) {
+    fprintf(stderr, "No usable path for the daemon socket.\n");
+    return -1;
+  }
+  attach_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (attach_fd == -1 ||
+      connect(attach_fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+    fprintf(stderr, "No daemon is listening on %s.\n", addr.sun_path);
+    return -1;
+  }
+  fcntl(attach_fd, F_SETFL, O_NONBLOCK);
+  watch_fd(attach_fd, EPOLLIN, WATCH_DAEMON, 0);
+  return 0;
+}
+
+// Stores the workflows of a W line, "repo<TAB>workflows", for the hover.
+void attach_workflows(char *line) {
+  char *text = strchr(line, '\t');
+  if (!text)
+    return;
+  *text++ = '\0';
+  int i = repo_lookup(line);
+  if (i < 0)
+    return;
+  for (char *p = text; (p = strchr(p, ';'));)
+    *p = '\n';
+  size_t len = strlen(text);
+  char *copy = malloc(len + 2);
+  if (!copy)
+    return;
+  snprintf(copy, len + 2, len ? "%s\n" : "%s", text);
+  free(workflow_text[i]);
+  workflow_text[i] = copy;
+  mark_dirty(i);
+}
+
+// Applies one line from the daemon to the local mirror of its table.
+void attach_line(char *line) {
+  if (strncmp(line, "W\t", 2) == 0) { // workflows hold tabs of their own
+    attach_workflows(line + 2);
+    return;
+  }
+  char *f[5] = {line};
+  int nf = 1;
+  for (char *p = line; *p && nf < 5; p++) {
+    if (*p == '\t') {
+      *p = '\0';
+      f[nf++] = p + 1;
+    }
+  }
+  if (strcmp(f[0], "H") == 0 && nf >= 2) {
+    num_users = atoi(f[1]);
+  } else if (strcmp(f[0], "R") == 0 && nf == 4) {
+    int i = repo_lookup(f[2]);
+    if (i < 0 && (i = repo_add(f[2])) < 0)
+      return;
+    repo_set_status_id(i, status_intern(f[3]), f[1][0] == '1');
+    mark_dirty(i);
+  } else if (strcmp(f[0], "P") == 0 && nf == 5) {
+    remote_busy = f[1][0] == '1';
+    remote_next_poll = strtoll(f[2], NULL, 10);
+    rate_remaining = strtol(f[3], NULL, 10);
+    rate_blocked_until = (time_t)strtoll(f[4], NULL, 10);
+  }
+}
+
+// Reads updates from the daemon. Returns false once it has gone away.
+bool attach_io(void) {
+  for (;;) {
+    ssize_t n = read(attach_fd, attach_in + attach_len,
+                     sizeof(attach_in) - attach_len - 1);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return true;
+    if (n <= 0)
+      return false;
+    attach_len += n;
+    attach_in[attach_len] = '\0';
+    char *nl;
+    while ((nl = strchr(attach_in, '\n'))) {
+      *nl = '\0';
+      attach_line(attach_in);
+      attach_len -= nl + 1 - attach_in;
+      memmove(attach_in, nl + 1, attach_len + 1);
     }
+    if (attach_len == sizeof(attach_in) - 1)
+      attach_len = 0; // drop an oversized line
   }
+}
 
-  if (status_changed && sort_mode != SORT_DEFAULT)
-    apply_sort();
+// Starts a full refresh here, or asks the daemon to when attached.
+void request_refresh(void) {
+  if (attach_fd == -1)
+    spawn_fetches();
+  else // a lost daemon shows up as a hangup on its socket
+    send(attach_fd, "refresh\n", 8, MSG_NOSIGNAL);
 }
 
 void cleanup(int pipes[][2], pid_t pids[]) {
+  save_etags();
+  save_snapshot();
+  discovery_shutdown();
+  hook_shutdown();
   for (int i = 0; i < NUM_REPOS; i++) {
-    free(REPOS[i]);
     if (pipes[i][0] != -1)
       close(pipes[i][0]);
     if (pipes[i][1] != -1)
@@ -280,13 +4435,13 @@ void cleanup(int pipes[][2], pid_t pids[]) {
       waitpid(pids[i], NULL, 0);
     }
   }
-}
-
-void handle_sigint(int signo) {
-  (void)signo;
-  cleanup(pipes, fetch_pids);
-  endwin();
-  exit(0);
+  if (fetch_engine == ENGINE_HTTP)
+    http_shutdown();
+  else if (fetch_engine == ENGINE_WORKERS)
+    worker_shutdown();
+  reap_children();
+  telemetry_close();
+  repo_table_free();
 }
 
 long long now_ms(void) {
@@ -295,6 +4450,31 @@ long long now_ms(void) {
   return (long long)ts.tv_sec * 1000LL + ts.tv_nsec / 1000000LL;
 }
 
+long long now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000LL;
+}
+
+// Formats wait_ms, the time until the next poll, as seconds or, a minute or
+// more out, as minutes. Returns the ms until the text changes, or -1 if it
+// will not change by itself.
+long long format_countdown(long long wait_ms, char *buf, size_t len) {
+  if (wait_ms < 0) {
+    snprintf(buf, len, "-");
+    return -1;
+  }
+  long long secs = (wait_ms + 999) / 1000;
+  if (secs < 60) {
+    snprintf(buf, len, "%llds", secs);
+    return secs > 0 ? wait_ms - (secs - 1) * 1000 : -1;
+  }
+  long long mins = (wait_ms + 59999) / 60000;
+  snprintf(buf, len, "%lldm", mins);
+  long long next = (mins - 1) * 60000;
+  return wait_ms - (next > 59000 ? next : 59000);
+}
+
 int sanitize_positive_option(const char *label, int value, int default_value,
                              int warn) {
   if (value < 1) {
@@ -308,49 +4488,117 @@ int sanitize_positive_option(const char *label, int value, int default_value,
   return value;
 }
 
-int cmp_alpha(const void *a, const void *b) {
-  int i = *(const int *)a;
-  int j = *(const int *)b;
-  return strcmp(REPOS[i], REPOS[j]);
-}
-
-int cmp_status(const void *a, const void *b) {
-  int i = *(const int *)a;
-  int j = *(const int *)b;
-  int c = strcmp(STATUS[i], STATUS[j]);
-  if (c == 0)
-    return strcmp(REPOS[i], REPOS[j]); // tie-break
-  return c;
+// Draws text at y, x, cut off after cols screen columns instead of wrapping
+// onto the next row. Returns the columns drawn.
+int draw_clipped(int y, int x, const char *text, int cols) {
+  wchar_t wide[512];
+  size_t n = mbstowcs(wide, text, sizeof(wide) / sizeof(wide[0]) - 1);
+  if (n == (size_t)-1)
+    return 0;
+  int used = 0;
+  size_t k = 0;
+  for (; k < n; k++) {
+    int w = wcwidth(wide[k]);
+    if (w > 0 && used + w > cols)
+      break;
+    used += w > 0 ? w : 0;
+  }
+  mvaddnwstr(y, x, wide, (int)k);
+  return used;
 }
 
-void apply_sort(void) {
-  memcpy(order, ORIGINAL_INDEX, NUM_REPOS * sizeof(int));
-  if (sort_mode == SORT_ALPHA) {
-    qsort(order, NUM_REPOS, sizeof(int), cmp_alpha);
-  } else if (sort_mode == SORT_STATUS) {
-    qsort(order, NUM_REPOS, sizeof(int), cmp_status);
-  }
+void print_usage(const char *prog) {
+  fprintf(stderr,
+          "Usage: %s [-p seconds>=1] [-c count>=1] [-e gh|workers|http] "
+          "[-u api-url] [--listen [host:]port] [--daemon] [--socket path] "
+          "[--telemetry file] [--workflows] [--branch list] "
+          "[--default-branch] [--delta] <github-username> "
+          "[user2 [user3 [...]]]\n"
+          "       %s --attach [--socket path]\n",
+          prog, prog);
 }
 
 int main(int argc, char **argv) {
   int poll_interval_s = POLL_INTERVAL_S;
   int max_concurrent_fetches = MAX_CONCURRENT_FETCHES;
+  const char *api_url = API_URL;
+  bool daemon_mode = false, attach_mode = false;
+  const char *socket_path = NULL, *listen_spec = NULL;
+  static const struct option long_options[] = {
+      {"daemon", no_argument, NULL, 'D'},
+      {"attach", no_argument, NULL, 'A'},
+      {"socket", required_argument, NULL, 'S'},
+      {"listen", required_argument, NULL, 'L'},
+      {"telemetry", required_argument, NULL, 'T'},
+      {"workflows", no_argument, NULL, 'F'},
+      {"branch", required_argument, NULL, 'B'},
+      {"default-branch", no_argument, NULL, 'M'},
+      {"delta", no_argument, NULL, 'R'},
+      {NULL, 0, NULL, 0}};
   int opt;
 
-  while ((opt = getopt(argc, argv, "hp:c:")) != -1) {
+  while ((opt = getopt_long(argc, argv, "hp:c:e:u:W", long_options, NULL)) !=
+         -1) {
     switch (opt) {
+    case 'D':
+      daemon_mode = true;
+      break;
+    case 'A':
+      attach_mode = true;
+      break;
+    case 'S':
+      socket_path = optarg;
+      break;
+    case 'L':
+      listen_spec = optarg;
+      break;
+    case 'F':
+      workflow_mode = true;
+      break;
+    case 'B':
+      workflow_mode = true;
+      branch_list = optarg;
+      break;
+    case 'M':
+      workflow_mode = branch_default = true;
+      break;
+    case 'R':
+      sched_delta = true;
+      break;
+    case 'T':
+      telemetry_file = fopen(optarg, "a");
+      if (!telemetry_file) {
+        perror(optarg);
+        return 1;
+      }
+      break;
     case 'p':
       poll_interval_s = atoi(optarg);
       break;
     case 'c':
       max_concurrent_fetches = atoi(optarg);
       break;
+    case 'e':
+      if (strcmp(optarg, "http") == 0) {
+        fetch_engine = ENGINE_HTTP;
+      } else if (strcmp(optarg, "workers") == 0) {
+        fetch_engine = ENGINE_WORKERS;
+      } else if (strcmp(optarg, "gh") == 0) {
+        fetch_engine = ENGINE_GH;
+      } else {
+        fprintf(stderr, "Unknown fetch engine '%s'.\n", optarg);
+        print_usage(argv[0]);
+        return 1;
+      }
+      break;
+    case 'u':
+      api_url = optarg;
+      break;
+    case 'W': // internal: run as a persistent fetch worker
+      return worker_main();
     case 'h':
     default:
-      fprintf(stderr,
-              "Usage: %s [-p seconds>=1] [-c count>=1] <github-username> [user2 "
-              "[user3 [...]]]\n",
-              argv[0]);
+      print_usage(argv[0]);
       return 0;
     }
   }
@@ -361,33 +4609,55 @@ int main(int argc, char **argv) {
       "max concurrent fetches", max_concurrent_fetches, MAX_CONCURRENT_FETCHES,
       1);
 
-  if (optind >= argc) {
-    fprintf(stderr,
-            "Usage: %s [-p seconds>=1] [-c count>=1] <github-username> [user2 [user3 "
-            "[...]]]\n",
-            argv[0]);
+  if ((optind >= argc && !attach_mode) || (daemon_mode && attach_mode)) {
+    print_usage(argv[0]);
     return 0;
   }
 
-  for (int i = optind; i < argc; i++)
-    load_repos(argv[i]);
-  int num_users = argc - optind;
-
-  if (NUM_REPOS == 0) {
-    fprintf(stderr, "No repos found for specified users, exiting...\n");
-    return 0;
+  loop_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (loop_fd == -1) {
+    perror("epoll_create1");
+    return 1;
   }
+  if (attach_mode) {
+    // the daemon does the fetching; this process only draws
+    if (attach_start(socket_path) != 0)
+      return 1;
+  } else {
+    if (daemon_mode && daemon_listen(socket_path) != 0)
+      return 1;
+    if (listen_spec && hook_listen(listen_spec) != 0)
+      return 1;
+    sched_pushed = listen_spec != NULL;
+    if (fetch_engine == ENGINE_HTTP &&
+        http_init(api_url, max_concurrent_fetches) != 0)
+      return 1;
+    if (fetch_engine == ENGINE_WORKERS)
+      worker_init(max_concurrent_fetches);
+    gh_max = max_concurrent_fetches;
 
-  for (int i = 0; i < NUM_REPOS; i++) {
-    ORIGINAL_INDEX[i] = i;
-    order[i] = i;
-  }
+    num_users = argc - optind;
+    sched_ceiling_s = poll_interval_s;
+    if (sched_delta) {
+      delta_interval_s = poll_interval_s;
+      sched_ceiling_s = poll_interval_s * DELTA_SWEEP_FACTOR;
+    }
+    srand((unsigned)getpid());
+    snapshot_init(argv + optind, num_users);
+    load_snapshot();
+    load_etags();
 
-  for (int i = 0; i < MAX_REPOS; i++) {
-    pipes[i][0] = pipes[i][1] = -1;
-    fetch_pids[i] = -1;
+    // show any last known statuses now; listed repos stream in behind them
+    discovery_start(argv + optind, num_users, max_concurrent_fetches);
+    spawn_fetches();
+  }
+  time_t last_snapshot = time(NULL);
+  int sig_fd = signals_watch();
+  if (daemon_mode) {
+    int rc = daemon_main(sig_fd, max_concurrent_fetches);
+    cleanup(pipes, fetch_pids);
+    return rc;
   }
-  spawn_fetches(pipes, fetch_pids, max_concurrent_fetches);
 
   setlocale(LC_CTYPE, "C.UTF-8");
   initscr();
@@ -400,6 +4670,7 @@ int main(int argc, char **argv) {
   noecho();
   curs_set(0);
   keypad(stdscr, TRUE);
+  set_escdelay(25); // Esc leaves the filter without a pause
   nodelay(stdscr, TRUE);
 
   // enable mouse support
@@ -417,9 +4688,26 @@ int main(int argc, char **argv) {
   init_pair(5, COLOR_BLUE, COLOR_GREEN);   // skipped
   init_pair(6, COLOR_RED, COLOR_YELLOW);   // action_required
   init_pair(7, COLOR_WHITE, COLOR_BLUE);   // in_progress
+  init_pair(8, COLOR_GREEN, -1);           // run history: success
+  init_pair(9, COLOR_RED, -1);             // run history: failed
+  init_pair(10, COLOR_YELLOW, -1);         // run history: running
 
-  signal(SIGINT, handle_sigint);
-  signal(SIGTERM, handle_sigint);
+  // input and timers arrive through the event loop too
+  watch_fd(STDIN_FILENO, EPOLLIN, WATCH_INPUT, 0);
+  enum {
+    TIMER_SPIN,
+    TIMER_COUNTDOWN,
+    TIMER_POLL,
+    TIMER_TELEMETRY,
+    TIMER_COUNT
+  };
+  int timers[TIMER_COUNT];
+  long long timer_at[TIMER_COUNT];
+  for (int t = 0; t < TIMER_COUNT; t++) {
+    timers[t] = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    timer_at[t] = -1;
+    watch_fd(timers[t], EPOLLIN, WATCH_TIMER, t);
+  }
 
   int ch;
   time_t last_poll = time(NULL);
@@ -432,156 +4720,185 @@ int main(int argc, char **argv) {
   int sp_col_start = 0, sp_col_end = 0;
   int s_col_start = 0, s_col_end = 0;
 
-  // main loop
-  while (1) {
-    erase();
+  // what is on screen, so each frame redraws only what changed
+  int drawn_count = 0;       // grid slots drawn so far
+  int scroll_row = 0;        // first grid row in view
+  int drawn_scroll = 0;
+  char drawn_position[40] = "";
+  bool filter_input = false; // keys go to the `/` filter
+  char drawn_filter[FILTER_MAX + 64] = "";
+  int drawn_rows = -1, drawn_cols = -1;
+  int drawn_counts[STATUS_COUNT];
+  int drawn_total = -1;
+  int stats_start[STATUS_COUNT] = {0}, stats_end[STATUS_COUNT] = {0};
+  char drawn_tooltip[512];
+  int drawn_tooltip_repo = -1; // repo whose run history the tooltip shows
+  RunHistory drawn_history;
+  int drawn_footer = -1;
+  char drawn_ticker[64];
+  bool show_telemetry = false;
+  bool wide_cells = false; // cells end in a sparkline of recent runs
 
+  // main loop: draw, then sleep until a fd, timer or signal needs attention
+  bool quit = false, no_repos = false, daemon_lost = false;
+  while (!quit) {
+    schedule_dispatch(max_concurrent_fetches);
+    long long frame_start = now_us();
+    if (order_dirty)
+      apply_sort();
+    if (filter_dirty)
+      filter_update();
+
+    // the spinner only turns while fetches or listings are outstanding
     long long now = now_ms();
-    if (now - last_spin_update >= SPIN_INTERVAL_MS) {
+    bool busy = attach_fd != -1 ? remote_busy
+                                : discovery_pending > 0 || fetches_busy() > 0;
+    if (busy && now - last_spin_update >= SPIN_INTERVAL_MS) {
       spinner_index = (spinner_index + 1) % nsc;
       last_spin_update = now;
     }
 
-    int secs_left = poll_interval_s - (int)(time(NULL) - last_poll);
-    if (secs_left < 0)
-      secs_left = 0;
+    long long wait_ms = schedule_wait_ms();
+    if (attach_fd != -1)
+      wait_ms = remote_next_poll < 0 ? -1
+                : remote_next_poll > now ? remote_next_poll - now
+                                         : 0;
+    if (wait_ms >= 0 && wait_ms < rate_limit_wait_s() * 1000LL)
+      wait_ms = rate_limit_wait_s() * 1000LL;
+    char countdown[16];
+    long long countdown_ms =
+        format_countdown(wait_ms, countdown, sizeof(countdown));
 
-    int row = 2;
-    int col = 0;
     int term_rows, term_cols;
     getmaxyx(stdscr, term_rows, term_cols);
 
-    int cell_w = 32;
+    int cell_w = wide_cells ? 32 + WIDE_RUNS + 1 : 32;
     int cols_fit = term_cols / cell_w;
     if (cols_fit < 1)
       cols_fit = 1;
 
-    struct pollfd pollfds[MAX_REPOS];
-    int poll_index[MAX_REPOS];
-    nfds_t poll_count = 0;
-    for (int i = 0; i < NUM_REPOS; i++) {
-      if (pipes[i][0] != -1) {
-        pollfds[poll_count].fd = pipes[i][0];
-        pollfds[poll_count].events = POLLIN;
-        pollfds[poll_count].revents = 0;
-        poll_index[poll_count] = i;
-        poll_count++;
-      }
-    }
-
-    const int poll_timeout_ms = 100;
-    int poll_result = 0;
-    if (poll_count > 0) {
-      poll_result = poll(pollfds, poll_count, poll_timeout_ms);
-      if (poll_result < 0) {
-        if (errno == EINTR)
-          continue;
-        // Unexpected error; skip processing this cycle.
-        continue;
-      }
-    } else {
-      poll_result = poll(NULL, 0, poll_timeout_ms);
-      if (poll_result < 0 && errno != EINTR)
-        continue;
+    if (term_rows != drawn_rows || term_cols != drawn_cols) {
+      erase(); // first frame or resized: everything is redrawn below
+      drawn_rows = term_rows;
+      drawn_cols = term_cols;
+      drawn_count = 0;
+      drawn_total = -1;
+      drawn_tooltip[0] = '\x01';
+      drawn_footer = -1;
+      drawn_ticker[0] = '\0';
+      drawn_position[0] = '\x01';
+      drawn_filter[0] = '\x01';
     }
 
-    bool updated_status = false;
-    for (nfds_t pi = 0; pi < poll_count; ++pi) {
-      if (!(pollfds[pi].revents & (POLLIN | POLLHUP | POLLERR)))
-        continue;
-
-      int i = poll_index[pi];
-      char buf[128];
-      int n = read(pipes[i][0], buf, sizeof(buf) - 1);
-      if (n > 0) {
-        buf[n] = '\0';
-        buf[strcspn(buf, "\n")] = 0;
-
-        if (strncmp(STATUS[i], buf, sizeof(STATUS[i])) != 0) {
-          strncpy(STATUS[i], buf, sizeof(STATUS[i]) - 1);
-          STATUS[i][sizeof(STATUS[i]) - 1] = '\0';
-          status_received[i] = 1;
-          updated_status = true;
-        }
-      } else if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
-        close(pipes[i][0]);
-        if (fetch_pids[i] > 0)
-          waitpid(fetch_pids[i], NULL, 0);
-        pipes[i][0] = -1;
-        fetch_pids[i] = -1;
-        if (!status_received[i]) {
-          strcpy(STATUS[i], "no_runs");
-        }
-      }
+    // the grid scrolls under a viewport; only the slots in view are drawn,
+    // and of those only the ones whose repo or status changed
+    int view_rows = term_rows > 5 ? term_rows - 4 : 1;
+    int shown = grid_count();
+    int grid_rows = (shown + cols_fit - 1) / cols_fit;
+    if (scroll_row > grid_rows - view_rows)
+      scroll_row = grid_rows - view_rows;
+    if (scroll_row < 0)
+      scroll_row = 0;
+    int first = scroll_row * cols_fit;
+    int visible = shown - first;
+    if (visible > view_rows * cols_fit)
+      visible = view_rows * cols_fit;
+    if (scroll_row != drawn_scroll) {
+      for (int slot = 0; slot < drawn_count; slot++)
+        drawn_repo[slot] = -1; // every slot shows another repo now
+      drawn_scroll = scroll_row;
     }
-
-    if (updated_status && sort_mode != SORT_DEFAULT)
-      apply_sort();
-
-    for (int oi = 0; oi < NUM_REPOS; oi++) {
-      int i = order[oi];
-      const wchar_t *icon = status_icon(STATUS[i]);
-      int color = status_color(STATUS[i]);
+    for (int slot = 0; slot < visible; slot++) {
+      int i = grid_repo(first + slot);
+      if (slot < drawn_count && drawn_repo[slot] == i && !repo_dirty[i])
+        continue;
+      drawn_repo[slot] = i;
+      repo_dirty[i] = false;
+      int row = 2 + slot / cols_fit;
+      int col = slot % cols_fit;
+      const StatusEntry *entry = &status_map[repo_kind(i)];
+      const wchar_t *icon = status_map[status_kind(status_id[i])].icon;
+      int color = entry->color;
+      mvprintw(row, col * cell_w, "%*s", cell_w, "");
       attron(COLOR_PAIR(color));
-      mvprintw(row, col * cell_w, "%ls %s", icon, REPOS[i]);
+      mvprintw(row, col * cell_w, "%ls %.*s", icon, 28, REPOS[i]);
       attroff(COLOR_PAIR(color));
-      col++;
-      if (col >= cols_fit) {
-        col = 0;
-        row++;
-      }
+      if (wide_cells)
+        draw_sparkline(row, col * cell_w + 32, i, WIDE_RUNS);
     }
+    for (int slot = visible; slot < drawn_count; slot++)
+      mvprintw(2 + slot / cols_fit, slot % cols_fit * cell_w, "%*s", cell_w,
+               "");
+    drawn_count = visible;
 
-    // stats
-    int counts[STATUS_COUNT] = {0};
-    for (int i = 0; i < NUM_REPOS; i++) {
-      int matched = 0;
-      for (size_t j = 0; j < STATUS_KNOWN; j++) {
-        if (strstr(STATUS[i], status_map[j].match)) {
-          counts[j]++;
-          matched = 1;
-          break;
-        }
+    // stats: status_counts is kept current as repos change status
+    if (drawn_total != NUM_REPOS ||
+        memcmp(drawn_counts, status_counts, sizeof(status_counts)) != 0) {
+      move(term_rows - 2, 0);
+      clrtoeol();
+      mvprintw(term_rows - 2, 0, "📦%d 👥%d", NUM_REPOS, num_users);
+      int stats_col = getcurx(stdscr);
+      for (size_t j = 0; j < STATUS_COUNT; j++) {
+        stats_start[j] = stats_col;
+        mvprintw(term_rows - 2, stats_col, " %ls%d", status_map[j].icon,
+                 status_counts[j]);
+        stats_end[j] = getcurx(stdscr);
+        stats_col = stats_end[j];
       }
-      if (!matched)
-        counts[STATUS_KNOWN]++;
+      memcpy(drawn_counts, status_counts, sizeof(status_counts));
+      drawn_total = NUM_REPOS;
     }
     const char *sort_label = (sort_mode == SORT_DEFAULT) ? "Default"
                              : (sort_mode == SORT_ALPHA) ? "Alphabetical"
                                                          : "Status";
 
-    mvprintw(term_rows - 2, 0, "📦%d 👥%d", NUM_REPOS, num_users);
-    int stats_col = getcurx(stdscr);
-    int stats_start[STATUS_COUNT];
-    int stats_end[STATUS_COUNT];
-    for (size_t j = 0; j < STATUS_COUNT; j++) {
-      stats_start[j] = stats_col;
-      mvprintw(term_rows - 2, stats_col, " %ls%d", status_map[j].icon,
-               counts[j]);
-      stats_end[j] = getcurx(stdscr);
-      stats_col = stats_end[j];
+    // the filter being typed or in force, on the row above the grid
+    char prompt[sizeof(drawn_filter)] = "";
+    if (filter_input || filter_active()) {
+      int n = snprintf(prompt, sizeof(prompt), "/%s%s", filter_text,
+                       filter_input ? "_" : "");
+      if (filter_kind >= 0)
+        n += snprintf(prompt + n, sizeof(prompt) - n, "  %s only",
+                      status_map[filter_kind].label);
+      snprintf(prompt + n, sizeof(prompt) - n, "  %d of %d", shown, NUM_REPOS);
+    }
+    if (strcmp(prompt, drawn_filter) != 0) {
+      move(1, 0);
+      clrtoeol();
+      mvprintw(1, 0, "%.*s", term_cols, prompt);
+      strcpy(drawn_filter, prompt);
     }
 
-    char tooltip[128] = "";
-    int repo_rows = (NUM_REPOS + cols_fit - 1) / cols_fit;
+    char tooltip[512] = "";
+    int tooltip_repo = -1;
+    int repo_rows = (visible + cols_fit - 1) / cols_fit;
     int repo_row_start = 2;
     int repo_row_end = repo_row_start + repo_rows;
     if (hover_x >= 0 && hover_y >= repo_row_start && hover_y < repo_row_end &&
         hover_x < cols_fit * cell_w) {
       int rel_row = hover_y - repo_row_start;
       int rel_col = hover_x / cell_w;
-      int index = rel_row * cols_fit + rel_col;
-      if (rel_col < cols_fit && index < NUM_REPOS) {
-        int repo_index = order[index];
-        const StatusEntry *entry = status_details(STATUS[repo_index]);
-        describe_status(STATUS[repo_index], entry->label, tooltip,
-                        sizeof(tooltip));
+      int index = first + rel_row * cols_fit + rel_col;
+      if (rel_col < cols_fit && index < shown) {
+        int repo_index = grid_repo(index);
+        const char *status = repo_status(repo_index);
+        const StatusEntry *entry =
+            &status_map[status_kind(status_id[repo_index])];
+        char desc[96];
+        describe_status(status, entry->label, desc, sizeof(desc));
+        char workflows[384] = "";
+        workflow_describe(repo_index, workflows, sizeof(workflows));
+        snprintf(tooltip, sizeof(tooltip), "%s%s%s%s",
+                 status_stale[repo_index] ? "stale, last known: " : "", desc,
+                 workflows[0] ? ": " : "", workflows);
+        if (run_history[repo_index].count)
+          tooltip_repo = repo_index;
       }
     } else if (hover_y == term_rows - 2 && hover_x >= 0) {
       for (size_t j = 0; j < STATUS_COUNT; j++) {
         if (hover_x >= stats_start[j] && hover_x < stats_end[j]) {
           snprintf(tooltip, sizeof(tooltip), "%s (%d)", status_map[j].label,
-                   counts[j]);
+                   status_counts[j]);
           break;
         }
       }
@@ -592,112 +4909,291 @@ int main(int argc, char **argv) {
         snprintf(tooltip, sizeof(tooltip), "Refresh repository statuses");
       } else if (hover_x >= s_col_start && hover_x <= s_col_end) {
         snprintf(tooltip, sizeof(tooltip), "Change sorting mode");
+      } else if (hover_x >= s_col_start + 16 && hover_x < s_col_start + 30 &&
+                 drawn_position[0] > '\x01') {
+        snprintf(tooltip, sizeof(tooltip),
+                 "Rows in view; scroll with arrows, PgUp/PgDn or the wheel");
+      }
+    }
+
+    if (strcmp(tooltip, drawn_tooltip) != 0 ||
+        tooltip_repo != drawn_tooltip_repo ||
+        (tooltip_repo >= 0 && memcmp(&drawn_history, &run_history[tooltip_repo],
+                                     sizeof(drawn_history)) != 0)) {
+      move(0, 0);
+      clrtoeol();
+      int x = draw_clipped(0, 0, tooltip, term_cols) + 2;
+      if (tooltip_repo >= 0) {
+        draw_sparkline(0, x, tooltip_repo, term_cols - x);
+        drawn_history = run_history[tooltip_repo];
       }
+      strcpy(drawn_tooltip, tooltip);
+      drawn_tooltip_repo = tooltip_repo;
     }
 
-    move(0, 0);
-    clrtoeol();
-    if (tooltip[0] != '\0')
-      mvprintw(0, 0, "%s", tooltip);
+    // --- footer buttons, redrawn when the hover or sort mode changes ---
+    int footer_hover = 0;
+    if (hover_y == term_rows - 1 && hover_x >= 0) {
+      if (hover_x <= 2)
+        footer_hover = 1;
+      else if (hover_x >= sp_col_start && hover_x <= sp_col_end)
+        footer_hover = 2;
+      else if (hover_x >= s_col_start && hover_x <= s_col_end)
+        footer_hover = 3;
+    }
+    if (footer_hover * 3 + (int)sort_mode != drawn_footer) {
+      move(term_rows - 1, 0);
 
-    // --- footer buttons ---
-    move(term_rows - 1, 0);
+      // [q]
+      attron(footer_hover == 1 ? A_REVERSE | A_BOLD : A_REVERSE);
+      printw("[q]");
+      attroff(A_REVERSE | A_BOLD);
+      printw(" Quit ");
+      q_col_start = 0;
+      q_col_end = 2;
 
-    // [q]
-    if (hover_y == term_rows - 1 && hover_x >= 0 && hover_x <= 2)
-      attron(A_REVERSE | A_BOLD);
-    else
-      attron(A_REVERSE);
-    printw("[q]");
-    attroff(A_REVERSE | A_BOLD);
-    printw(" Quit ");
-    q_col_start = 0;
-    q_col_end = 2;
-
-    // [space]
-    int sp_start = getcurx(stdscr);
-    if (hover_y == term_rows - 1 && hover_x >= sp_start &&
-        hover_x <= sp_start + 6)
-      attron(A_REVERSE | A_BOLD);
-    else
-      attron(A_REVERSE);
-    printw("[space]");
-    attroff(A_REVERSE | A_BOLD);
-    printw(" Refresh ");
-    sp_col_start = sp_start;
-    sp_col_end = sp_start + 6;
-
-    // [s]
-    int s_start = getcurx(stdscr);
-    if (hover_y == term_rows - 1 && hover_x >= s_start &&
-        hover_x <= s_start + 2)
-      attron(A_REVERSE | A_BOLD);
-    else
-      attron(A_REVERSE);
-    printw("[s]");
-    attroff(A_REVERSE | A_BOLD);
-    printw(" %-12s", sort_label);
-    s_col_start = s_start;
-    s_col_end = s_start + 2;
+      // [space]
+      int sp_start = getcurx(stdscr);
+      attron(footer_hover == 2 ? A_REVERSE | A_BOLD : A_REVERSE);
+      printw("[space]");
+      attroff(A_REVERSE | A_BOLD);
+      printw(" Refresh ");
+      sp_col_start = sp_start;
+      sp_col_end = sp_start + 6;
 
-    mvprintw(term_rows - 1, getmaxx(stdscr) - 10, "%lc %ds",
-             spinner_chars[spinner_index], secs_left);
+      // [s]
+      int s_start = getcurx(stdscr);
+      attron(footer_hover == 3 ? A_REVERSE | A_BOLD : A_REVERSE);
+      printw("[s]");
+      attroff(A_REVERSE | A_BOLD);
+      printw(" %-12s", sort_label);
+      s_col_start = s_start;
+      s_col_end = s_start + 2;
+      drawn_footer = footer_hover * 3 + (int)sort_mode;
+    }
 
-    refresh();
+    // which rows are in view, once there are more than fit
+    char position[40] = "";
+    int position_col = s_col_start + 16;
+    if (grid_rows > view_rows)
+      snprintf(position, sizeof(position), "%d-%d/%d", scroll_row + 1,
+               scroll_row + view_rows, grid_rows);
+    if (strcmp(position, drawn_position) != 0 &&
+        position_col + 14 <= term_cols - 24) {
+      mvprintw(term_rows - 1, position_col, "%-14.14s", position);
+      strcpy(drawn_position, position);
+    }
 
-    if (time(NULL) - last_poll >= poll_interval_s) {
-      spawn_fetches(pipes, fetch_pids, max_concurrent_fetches);
-      last_poll = time(NULL);
+    // budget, spinner and countdown: the only part that changes when idle
+    char budget[32] = "", ticker[64];
+    long rate_wait_s = rate_limit_wait_s();
+    if (rate_wait_s > 0)
+      snprintf(budget, sizeof(budget), "API wait %lds", rate_wait_s);
+    else if (rate_remaining >= 0)
+      snprintf(budget, sizeof(budget), "API %ld", rate_remaining);
+    snprintf(ticker, sizeof(ticker), "%s|%d|%s", budget, spinner_index,
+             countdown);
+    if (strcmp(ticker, drawn_ticker) != 0) {
+      mvprintw(term_rows - 1, term_cols - 24, "%14s", budget);
+      mvprintw(term_rows - 1, term_cols - 10, "%lc %-6s",
+               spinner_chars[spinner_index], countdown);
+      strcpy(drawn_ticker, ticker);
     }
 
-    ch = getch();
-    if (ch == 'q' || ch == 'Q')
-      break;
-    if (ch == ' ' && time(NULL) - last_poll >= 1) {
-      spawn_fetches(pipes, fetch_pids, max_concurrent_fetches);
-      last_poll = time(NULL);
-    }
-    if (ch == 's' || ch == 'S') {
-      if (sort_mode == SORT_DEFAULT) {
-        sort_mode = SORT_ALPHA;
-      } else if (sort_mode == SORT_ALPHA) {
-        sort_mode = SORT_STATUS;
-      } else {
-        sort_mode = SORT_DEFAULT;
+    if (show_telemetry)
+      draw_telemetry(term_cols);
+    refresh();
+    hist_record(&hists[HIST_FRAME], now_us() - frame_start);
+
+    // arm the timers for the next thing that has to happen by itself
+    long long poll_ms = dispatch_wait_ms(max_concurrent_fetches);
+    timer_arm(timers[TIMER_SPIN], &timer_at[TIMER_SPIN],
+              busy ? last_spin_update + SPIN_INTERVAL_MS : -1);
+    timer_arm(timers[TIMER_COUNTDOWN], &timer_at[TIMER_COUNTDOWN],
+              countdown_ms >= 0 ? now + countdown_ms : -1);
+    timer_arm(timers[TIMER_POLL], &timer_at[TIMER_POLL],
+              poll_ms >= 0 ? now_ms() + poll_ms : -1);
+    long long dump_at = telemetry_dump();
+    if (show_telemetry && (dump_at < 0 || dump_at > now + 1000))
+      dump_at = now + 1000; // the overlay ticks once a second
+    timer_arm(timers[TIMER_TELEMETRY], &timer_at[TIMER_TELEMETRY], dump_at);
+
+    struct epoll_event events[64];
+    int nev = epoll_wait(loop_fd, events, 64, -1);
+    bool input_ready = false;
+    for (int e = 0; e < nev; e++) {
+      int index = (int)(uint32_t)events[e].data.u64;
+      switch ((WatchKind)(events[e].data.u64 >> 32)) {
+      case WATCH_GH:
+        gh_io(index);
+        break;
+      case WATCH_ENGINE:
+        engine_io(index);
+        break;
+      case WATCH_DISCOVERY:
+        discovery_io(&discovery[index]);
+        break;
+      case WATCH_TIMER: {
+        uint64_t expirations;
+        if (read(timers[index], &expirations, sizeof(expirations)) > 0)
+          timer_at[index] = -1;
+        break;
+      }
+      case WATCH_SIGNAL: {
+        struct signalfd_siginfo si;
+        while (read(sig_fd, &si, sizeof(si)) == sizeof(si)) {
+          if (si.ssi_signo == SIGINT || si.ssi_signo == SIGTERM) {
+            quit = true;
+          } else if (si.ssi_signo == SIGWINCH) {
+            struct winsize ws;
+            if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0)
+              resizeterm(ws.ws_row, ws.ws_col);
+          }
+        }
+        break;
+      }
+      case WATCH_CHILD:
+        reap_io(index);
+        break;
+      case WATCH_LISTING:
+        discovery_finish(&discovery[index]);
+        break;
+      case WATCH_INPUT:
+        input_ready = true;
+        break;
+      case WATCH_DAEMON:
+        if (!attach_io())
+          quit = daemon_lost = true;
+        break;
+      case WATCH_HOOK_LISTEN:
+        hook_accept();
+        break;
+      case WATCH_HOOK:
+        hook_io(index);
+        break;
+      default:
+        break;
       }
-      apply_sort();
     }
-    if (ch == KEY_MOUSE) {
-      MEVENT ev;
-      if (getmouse(&ev) == OK) {
-        hover_x = ev.x;
-        hover_y = ev.y;
-        if (ev.bstate & BUTTON1_CLICKED) {
-          int footer_row = term_rows - 1;
-          if (ev.y == footer_row) {
-            if (ev.x >= q_col_start && ev.x <= q_col_end) {
-              break; // clicked [q]
-            } else if (ev.x >= sp_col_start && ev.x <= sp_col_end) {
-              if (time(NULL) - last_poll >= 1) {
-                spawn_fetches(pipes, fetch_pids, max_concurrent_fetches);
-                last_poll = time(NULL);
+
+    // every listing came back empty: nothing to show
+    if (attach_fd == -1 && discovery_pending == 0 && NUM_REPOS == 0)
+      quit = no_repos = true;
+
+    // keys and mouse events queued on the terminal
+    while (input_ready && !quit && (ch = getch()) != ERR) {
+      if (filter_input && ch != KEY_MOUSE && ch != KEY_RESIZE) {
+        if (ch == '\n' || ch == KEY_ENTER) {
+          filter_input = false;
+        } else if (ch == 27) {
+          filter_clear();
+          filter_input = false;
+        } else if (ch == KEY_BACKSPACE || ch == 127 || ch == '\b') {
+          filter_pop();
+        } else if (ch == '\t') {
+          filter_kind = filter_kind + 1 < (int)STATUS_COUNT ? filter_kind + 1
+                                                            : -1;
+          filter_dirty = true;
+        } else if (ch >= ' ' && ch < 127) {
+          filter_push(ch);
+        }
+        scroll_row = 0;
+        continue;
+      }
+      if (ch == '/') {
+        filter_input = true;
+        continue;
+      }
+      if (ch == 27 && filter_active()) {
+        filter_clear();
+        scroll_row = 0;
+      }
+      if (ch == 'q' || ch == 'Q') {
+        quit = true;
+        break;
+      }
+      if (ch == ' ' && time(NULL) - last_poll >= 1) {
+        request_refresh();
+        last_poll = time(NULL);
+      }
+      if (ch == 's' || ch == 'S') {
+        if (sort_mode == SORT_DEFAULT) {
+          sort_mode = SORT_ALPHA;
+        } else if (sort_mode == SORT_ALPHA) {
+          sort_mode = SORT_STATUS;
+        } else {
+          sort_mode = SORT_DEFAULT;
+        }
+        apply_sort();
+      }
+      if (ch == KEY_DOWN || ch == 'j')
+        scroll_row++;
+      if (ch == KEY_UP || ch == 'k')
+        scroll_row--;
+      if (ch == KEY_NPAGE)
+        scroll_row += view_rows;
+      if (ch == KEY_PPAGE)
+        scroll_row -= view_rows;
+      if (ch == KEY_HOME)
+        scroll_row = 0;
+      if (ch == KEY_END)
+        scroll_row = grid_rows; // clamped to the last page when drawn
+      if (ch == 'w' || ch == 'W') {
+        wide_cells = !wide_cells;
+        drawn_rows = -1; // the grid reflows to the new cell width
+      }
+      if (ch == 't' || ch == 'T') {
+        show_telemetry = !show_telemetry;
+        if (!show_telemetry)
+          drawn_rows = -1; // uncover the cells beneath it
+      }
+      if (ch == KEY_MOUSE) {
+        MEVENT ev;
+        if (getmouse(&ev) == OK) {
+          hover_x = ev.x;
+          hover_y = ev.y;
+          if (ev.bstate & BUTTON4_PRESSED)
+            scroll_row -= WHEEL_ROWS;
+#ifdef BUTTON5_PRESSED
+          if (ev.bstate & BUTTON5_PRESSED)
+            scroll_row += WHEEL_ROWS;
+#endif
+          if (ev.bstate & BUTTON1_CLICKED) {
+            int footer_row = term_rows - 1;
+            if (ev.y == footer_row) {
+              if (ev.x >= q_col_start && ev.x <= q_col_end) {
+                quit = true; // clicked [q]
+              } else if (ev.x >= sp_col_start && ev.x <= sp_col_end) {
+                if (time(NULL) - last_poll >= 1) {
+                  request_refresh();
+                  last_poll = time(NULL);
+                }
+              } else if (ev.x >= s_col_start && ev.x <= s_col_end) {
+                if (sort_mode == SORT_DEFAULT)
+                  sort_mode = SORT_ALPHA;
+                else if (sort_mode == SORT_ALPHA)
+                  sort_mode = SORT_STATUS;
+                else
+                  sort_mode = SORT_DEFAULT;
+                apply_sort();
               }
-            } else if (ev.x >= s_col_start && ev.x <= s_col_end) {
-              if (sort_mode == SORT_DEFAULT)
-                sort_mode = SORT_ALPHA;
-              else if (sort_mode == SORT_ALPHA)
-                sort_mode = SORT_STATUS;
-              else
-                sort_mode = SORT_DEFAULT;
-              apply_sort();
             }
           }
         }
       }
     }
+
+    if (snapshot_dirty && time(NULL) - last_snapshot >= SNAPSHOT_INTERVAL_S) {
+      save_snapshot();
+      last_snapshot = time(NULL);
+    }
   }
 
   cleanup(pipes, fetch_pids);
   endwin();
+  if (no_repos)
+    fprintf(stderr, "No repos found for specified users, exiting...\n");
+  if (daemon_lost)
+    fprintf(stderr, "Lost connection to the daemon.\n");
   return 0;
 }
@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <assert.h>
 #include <locale.h>
 #include <wchar.h>
@@ -19,5 +20,369 @@ int main(void) {
 
   assert(sanitize_positive_option("test", 5, 10, 0) == 5);
   assert(sanitize_positive_option("test", 0, 10, 0) == 10);
+
+  ApiBase base;
+  assert(parse_api_url("http://127.0.0.1:8080/api/", &base) == 0);
+  assert(!base.tls && strcmp(base.host, "127.0.0.1") == 0);
+  assert(strcmp(base.port, "8080") == 0 && strcmp(base.prefix, "/api") == 0);
+  assert(parse_api_url("https://api.github.com", &base) == 0);
+  assert(base.tls && strcmp(base.port, "443") == 0 && base.prefix[0] == 0);
+  assert(parse_api_url("ftp://example.com", &base) == -1);
+
+  char resp[] = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                "4\r\nabcd\r\n2\r\nef\r\n0\r\n\r\n";
+  size_t resp_len = strlen(resp);
+  HttpResponse r;
+  assert(http_parse_response(resp, 20, false, &r) == 0);
+  assert(http_parse_response(resp, resp_len, false, &r) == (long)resp_len);
+  assert(r.code == 200 && r.keep_alive && r.body_len == 6);
+  assert(memcmp(r.body, "abcdef", 6) == 0);
+  char huge[] = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                "ffffffffffffffff\r\nab\r\n0\r\n\r\n";
+  assert(http_parse_response(huge, strlen(huge), false, &r) == -1);
+  char partial[] = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                   "fffffff\r\nab\r\n0\r\n\r\n";
+  assert(http_parse_response(partial, strlen(partial), false, &r) == 0);
+  char closed[] = "HTTP/1.1 404 Not Found\r\nConnection: close\r\n"
+                  "Content-Length: 2\r\n\r\n{}";
+  assert(http_parse_response(closed, strlen(closed), false, &r) > 0);
+  assert(r.code == 404 && !r.keep_alive && r.body_len == 2);
+
+  char text[160];
+  const char *runs = "{\"total_count\":2,\"workflow_runs\":[{\"id\":7,"
+                     "\"head\":{\"status\":\"x\"},\"status\":\"completed\","
+                     "\"conclusion\":\"failure\","
+                     "\"created_at\":\"2024-02-28T23:59:00Z\","
+                     "\"run_started_at\":\"2024-02-28T23:59:30Z\","
+                     "\"updated_at\":\"2024-02-29T00:01:00Z\","
+                     "\"workflow_id\":3,\"head_branch\":\"main\","
+                     "\"name\":\"CI; nightly\"},{\"id\":5,"
+                     "\"status\":\"completed\",\"conclusion\":\"success\","
+                     "\"created_at\":\"2024-02-28T10:00:00Z\","
+                     "\"updated_at\":\"2024-02-28T10:00:04Z\"}]}";
+  assert(parse_runs_status(runs, strlen(runs), text, sizeof(text)) == 0);
+  assert(strcmp(text, "completed failure\t7 completed failure 90 3 main CI  "
+                      "nightly;5 completed success 4 null - ") == 0);
+  char short_text[64]; // only whole runs are kept
+  assert(parse_runs_status(runs, strlen(runs), short_text,
+                           sizeof(short_text)) == 0);
+  assert(strcmp(short_text, "completed failure\t7 completed failure 90 3 main "
+                            "CI  nightly") == 0);
+  const char *pending = "{\"workflow_runs\":[{\"status\":\"queued\","
+                        "\"conclusion\":null}]}";
+  assert(parse_runs_status(pending, strlen(pending), text, sizeof(text)) == 0);
+  assert(strcmp(text, "queued null\t queued null 0 null - ") == 0);
+  const char *none = "{\"total_count\":0,\"workflow_runs\":[]}";
+  assert(parse_runs_status(none, strlen(none), text, sizeof(text)) == 0);
+  assert(strcmp(text, "no_runs") == 0);
+
+  int code;
+  char etag[96];
+  RateLimit rl;
+  assert(parse_gh_api_output("HTTP/2.0 200 OK\r\nEtag: W/\"abc\"\r\n"
+                             "X-Ratelimit-Remaining: 4999\r\n"
+                             "X-Ratelimit-Reset: 1700000000\r\n\r\n"
+                             "completed success\n",
+                             &code, etag, sizeof(etag), text, sizeof(text),
+                             &rl) == 0);
+  assert(code == 200 && strcmp(etag, "W/\"abc\"") == 0);
+  assert(strcmp(text, "completed success") == 0);
+  assert(rl.remaining == 4999 && rl.reset == 1700000000 && !rl.retry_after);
+  assert(parse_gh_api_output("HTTP/2.0 304 Not Modified\r\n\r\n", &code, etag,
+                             sizeof(etag), text, sizeof(text), &rl) == 0);
+  assert(code == 304 && text[0] == '\0' && rl.remaining == -1);
+  assert(parse_gh_api_output("", &code, etag, sizeof(etag), text,
+                             sizeof(text), &rl) == -1);
+
+  RateLimit ok = {4000, time(NULL) + 3600, 0};
+  RateLimit secondary = {-1, 0, 60};
+  assert(!rate_limit_update(200, &ok) && rate_remaining == 4000);
+  assert(rate_limit_take() && rate_limit_wait_s() == 0);
+  assert(!rate_limit_update(403, &ok));
+  assert(rate_limit_update(403, &secondary) && rate_limit_wait_s() >= 59);
+  assert(!rate_limit_take());
+  rate_blocked_until = 0;
+  // a spent budget waits for its reset, then refills instead of sticking
+  rate_remaining = 0;
+  rate_reset = time(NULL) + 30;
+  rate_tokens = 0.5;
+  assert(!rate_limit_take() && rate_limit_delay_ms() >= 29000);
+  rate_reset = time(NULL) - 1;
+  assert(rate_limit_delay_ms() == 0 && rate_limit_take());
+  assert(rate_remaining == -1 && rate_tokens == RATE_BURST);
+
+  assert(repo_add("octo/alpha") == 0 && repo_add("octo/beta") == 1);
+  assert(repo_lookup("octo/beta") == 1);
+  assert(repo_lookup("octo/alpha") == 0);
+  assert(repo_lookup("octo/gamma") == -1);
+
+  char dir[] = "/tmp/ghstatus-test-XXXXXX";
+  assert(mkdtemp(dir));
+  setenv("XDG_CACHE_HOME", dir, 1);
+  char *users[] = {"octo"};
+  snapshot_init(users, 1);
+  set_status(0, "completed success");
+  mark_loading(1);
+  order[0] = 1;
+  order[1] = 0;
+  save_snapshot();
+  repo_truncate(0);
+  assert(load_snapshot());
+  assert(NUM_REPOS == 2 && strcmp(REPOS[1], "octo/beta") == 0);
+  assert(strcmp(repo_status(0), "completed success") == 0);
+  assert(status_received[0] && repo_lookup("octo/beta") == 1);
+  assert(status_stale[0] && status_stale[1] && !status_received[1]);
+  assert(status_counts[ST_STALE] == 2 && status_counts[ST_SUCCESS] == 0);
+  assert(order[0] == 1 && order[1] == 0);
+  assert(!order_dirty && order_pos[1] == 0 && order_pos[0] == 1);
+  unlink(snapshot_file);
+  char cache_dir[PATH_MAX];
+  snprintf(cache_dir, sizeof(cache_dir), "%s/ghstatus", dir);
+  rmdir(cache_dir);
+  rmdir(dir);
+
+  assert(status_active("in_progress null") && status_active("queued null"));
+  assert(!status_active("completed success") && !status_active("no_runs"));
+  sched_ceiling_s = 300;
+  set_status(0, "completed success");
+  set_status(1, "in_progress null");
+  assert(status_counts[ST_SUCCESS] == 1 && status_counts[ST_STALE] == 0);
+  assert(status_counts[ST_IN_PROGRESS] == 1 && status_counts[ST_LOADING] == 0);
+  sort_mode = SORT_STATUS;
+  apply_sort();
+  assert(order[0] == 1 && order[1] == 0 && order_pos[0] == 1);
+  set_status(1, "completed failure");
+  assert(order[0] == 1 && status_counts[ST_FAILURE] == 1);
+  set_status(0, "completed failure"); // ties fall back to name order
+  assert(order[0] == 0 && order[1] == 1 && order_pos[1] == 1);
+  set_status(0, "completed success");
+  assert(order[0] == 1 && order[1] == 0);
+  sort_mode = SORT_DEFAULT;
+  set_status(1, "in_progress null");
+  schedule_next(0, true);
+  schedule_next(1, true);
+  assert(poll_backoff_s[0] == BACKOFF_BASE_S && poll_backoff_s[1] == 0);
+  schedule_next(0, false);
+  assert(poll_backoff_s[0] == 2 * BACKOFF_BASE_S);
+  assert(schedule_pop() == 1 && schedule_pop() == 0 && sched_len == 0);
+  // a rate limited fetch is retried once the block lifts, on the same clock
+  RateLimit spent = {0, time(NULL) + 30, 0};
+  apply_fetch(1, 403, "", "", &spent);
+  assert(rate_limit_wait_s() >= 29);
+  assert(next_due[1] > now_ms() && next_due[1] <= now_ms() + 32000);
+  assert(schedule_pop() == 1 && sched_len == 0);
+  rate_blocked_until = 0;
+  rate_remaining = -1;
+
+  // the table grows past its initial capacity with names and index intact
+  char name[32];
+  for (int i = 2; i < 5000; i++) {
+    snprintf(name, sizeof(name), "octo/r%d", i);
+    assert(repo_add(name) == i);
+  }
+  assert(repo_lookup("octo/r4999") == 4999 && repo_lookup("octo/beta") == 1);
+  assert(strcmp(REPOS[0], "octo/alpha") == 0 && pipes[4999][0] == -1);
+  assert(status_intern("completed success") == status_id[0]);
+
+  // a daemon's repo lines rebuild the same table in an attached client
+  char line[512];
+  daemon_repo_line(0, line, sizeof(line));
+  assert(strcmp(line, "R\t0\tocto/alpha\tcompleted success\n") == 0);
+  repo_truncate(0);
+  *strchr(line, '\n') = '\0';
+  attach_line(line);
+  char state[] = "P\t1\t-1\t4321\t0";
+  attach_line(state);
+  assert(NUM_REPOS == 1 && strcmp(repo_status(0), "completed success") == 0);
+  assert(remote_busy && rate_remaining == 4321 && remote_next_poll == -1);
+  const char *ci_docs = "completed failure\tCI (main)\nqueued null\tDocs\n";
+  workflow_text[0] = strdup(ci_docs);
+  char wline[DAEMON_LINE_MAX];
+  int wlen = daemon_workflow_line(0, wline, sizeof(wline));
+  assert(strcmp(wline, "W\tocto/alpha\tcompleted failure\tCI (main);"
+                       "queued null\tDocs\n") == 0);
+  assert(wlen == (int)strlen(wline));
+  free(workflow_text[0]);
+  workflow_text[0] = NULL;
+  wline[wlen - 1] = '\0';
+  attach_line(wline);
+  assert(strcmp(workflow_text[0], ci_docs) == 0);
+  free(workflow_text[0]);
+  workflow_text[0] = NULL;
+
+  // recorded webhook deliveries and GitHub's documented signature example
+  const char *hook = "{\"action\":\"completed\",\"workflow_run\":{\"id\":1,"
+                     "\"status\":\"completed\",\"conclusion\":\"failure\"},"
+                     "\"repository\":{\"full_name\":\"octo/alpha\"}}";
+  char repo[64];
+  assert(parse_webhook("workflow_run", hook, strlen(hook), repo, sizeof(repo),
+                       text, sizeof(text)) == 1);
+  assert(strcmp(repo, "octo/alpha") == 0 &&
+         strcmp(text, "completed failure\t1 completed failure 0") == 0);
+  assert(hook_deliver("workflow_run", hook, strlen(hook)) == 202);
+  assert(strcmp(repo_status(0), "completed failure") == 0);
+  assert(parse_webhook("push", hook, strlen(hook), repo, sizeof(repo), text,
+                       sizeof(text)) == 0);
+  assert(parse_webhook("workflow_job", "{\"workflow_job\":{}}", 19, repo,
+                       sizeof(repo), text, sizeof(text)) == -1);
+  assert(hook_signature_ok("It's a Secret to Everybody", "Hello, World!", 13,
+                           "sha256=757107ea0eb2509fc211221cce984b8a37570b6d"
+                           "7586c22c46f4379c8b043e17"));
+  assert(!hook_signature_ok("wrong", "Hello, World!", 13,
+                            "sha256=757107ea0eb2509fc211221cce984b8a37570b6d"
+                            "7586c22c46f4379c8b043e17"));
+
+  // histogram buckets stay within an eighth of the recorded value
+  Histogram h = {.name = "t"};
+  for (int v = 1; v <= 1000; v++)
+    hist_record(&h, v * 1000);
+  assert(h.count == 1000 && h.max == 1000000);
+  assert(hist_percentile(&h, 50) <= 500000 && hist_percentile(&h, 50) > 437500);
+  assert(hist_percentile(&h, 99) <= 990000 && hist_percentile(&h, 99) > 866250);
+  assert(hist_percentile(&h, 100) <= h.max);
+  hist_json(&h, line, sizeof(line));
+  assert(strncmp(line, "\"t_ms\":{\"p50\":", 14) == 0);
+
+  // the `/` filter matches substrings in any case, in display order
+  repo_truncate(0);
+  const char *names[] = {"octo/Web-App", "octo/api", "acme/webhooks", "ab"};
+  for (int k = 0; k < 4; k++)
+    repo_add(names[k]);
+  sort_mode = SORT_ALPHA;
+  apply_sort();
+  filter_push('w');
+  filter_push('E');
+  filter_push('b');
+  filter_update();
+  assert(filter_view_len == 2 && filter_view[0] == 2 && filter_view[1] == 0);
+  filter_push('-');
+  filter_update();
+  assert(filter_view_len == 1 && grid_repo(0) == 0);
+  filter_pop();
+  filter_update();
+  assert(grid_count() == 2);
+  repo_add("zed/web");
+  filter_update();
+  assert(grid_count() == 3 && grid_repo(2) == 4);
+  filter_clear();
+  filter_push('b');
+  filter_update();
+  assert(grid_count() == 4);
+  filter_clear();
+  assert(!filter_active() && grid_count() == NUM_REPOS);
+  sort_mode = SORT_DEFAULT;
+
+  // the posix_spawn launcher wires stdout to the pipe it returns
+  char *echo_argv[] = {"printf", "ok", NULL};
+  int out_fd;
+  pid_t pid = spawn_reader(echo_argv, &out_fd);
+  assert(pid > 0);
+  char got[8] = "";
+  assert(read(out_fd, got, sizeof(got) - 1) == 2 && strcmp(got, "ok") == 0);
+  close(out_fd);
+  reap_child(pid);
+  reap_children();
+  assert(waitpid(pid, NULL, WNOHANG) == -1 && errno == ECHILD);
+
+  // run history takes whole pages at first, then updates and appends runs
+  wchar_t glyphs[HISTORY_RUNS + 1];
+  int kinds[HISTORY_RUNS];
+  assert(history_page(0) == HISTORY_RUNS);
+  assert(apply_fetch(0, 200, "\"r1\"",
+                     "in_progress null\t12 in_progress null 60;"
+                     "9 completed success 600",
+                     NULL));
+  assert(run_history[0].count == 2 && history_page(0) == HISTORY_PAGE);
+  assert(strcmp(fetch_etag(0), "\"r1\"") == 0);
+  // a cached ETag may answer a smaller page than an empty history asks for
+  snprintf(repo_etag[1], sizeof(repo_etag[1]), "\"c\"");
+  etag_status[1] = status_intern("completed success");
+  assert(run_history[1].count == 0 && !fetch_etag(1)[0]);
+  etag_status[1] = status_intern("no_runs");
+  assert(strcmp(fetch_etag(1), "\"c\"") == 0);
+  etag_status[1] = 0;
+  assert(history_sparkline(0, glyphs, kinds, 8) == 2 &&
+         wcscmp(glyphs, L"█▁") == 0 && kinds[0] == ST_SUCCESS &&
+         kinds[1] == ST_IN_PROGRESS);
+  assert(history_apply(0, "12 completed failure 65;9 completed success 600"));
+  assert(!history_apply(0, "12 completed failure 65"));
+  assert(history_sparkline(0, glyphs, kinds, 1) == 1 && kinds[0] == ST_FAILURE);
+  for (int id = 13; id < 13 + HISTORY_RUNS; id++) {
+    snprintf(text, sizeof(text), "%d completed success 1", id);
+    assert(history_apply(0, text));
+  }
+  assert(run_history[0].count == HISTORY_RUNS && run_history[0].last_id == 44);
+  assert(!history_apply(0, "12 completed success 1")); // fell out of the ring
+  assert(history_apply(0, "40 completed failure 1"));
+  assert(history_apply(0, "99999999 queued null 0"));
+  assert(history_apply(0, "99999999 completed success 3"));
+  assert(history_apply(0, "40 completed cancelled 1")); // ids far apart match
+
+  // --workflows keeps each workflow's latest run and shows the most urgent
+  char worst[64];
+  const char *mixed = "12 completed success 5 1 docs-fix Docs;"
+                      "11 in_progress null 5 2 main CI;"
+                      "10 completed failure 5 2 main CI;"
+                      "9 completed failure 5 1 main Docs";
+  assert(workflow_reduce(0, mixed, worst, sizeof(worst)));
+  assert(strcmp(worst, "in_progress null") == 0);
+  assert(strcmp(workflow_text[0],
+                "completed success\tDocs\nin_progress null\tCI\n") == 0);
+  assert(!workflow_reduce(0, mixed, worst, sizeof(worst)));
+  branch_default = true;
+  default_branch[0] = branch_intern("main");
+  assert(workflow_reduce(0, mixed, worst, sizeof(worst)));
+  assert(strcmp(worst, "completed failure") == 0);
+  assert(strcmp(workflow_text[0], "in_progress null\tCI (main)\n"
+                                  "completed failure\tDocs (main)\n") == 0);
+  branch_default = false;
+  branch_list = "release,docs-fix";
+  assert(workflow_reduce(0, mixed, worst, sizeof(worst)));
+  assert(strcmp(worst, "completed success") == 0);
+  branch_list = NULL;
+  assert(workflow_reduce(0, "", worst, sizeof(worst)));
+  assert(strcmp(worst, "no_runs") == 0 && !workflow_text[0][0]);
+
+  // a --delta pass polls the repos pushed since the previous listing at once
+  Discovery listing = {.user = "octo"};
+  char first_seen[] = "octo/api\tmain\t2024-03-01T10:00:00Z";
+  char pushed_again[] = "octo/api\tmain\t2024-03-01T10:05:00Z";
+  char untouched[] = "octo/api\tmain\t2024-03-01T10:05:00Z";
+  sched_delta = true;
+  assert(!discovery_line(&listing, first_seen));
+  assert(pushed_at[1] == iso_time("2024-03-01T10:00:00Z"));
+  assert(strcmp(branch_names[default_branch[1]], "main") == 0);
+  schedule_at(1, now_ms() + 60000);
+  assert(!discovery_line(&listing, pushed_again));
+  assert(next_due[1] <= now_ms() && listing.pushed == 1);
+  schedule_at(1, now_ms() + 60000);
+  assert(!discovery_line(&listing, untouched));
+  assert(next_due[1] > now_ms() && listing.listed == 3 && listing.pushed == 1);
+  sched_delta = false;
+
+  // a worker's late answer to a cancelled or restarted fetch is dropped
+  Worker idle = {.repo = -1};
+  in_flight[1] = refresh_owed[1] = true;
+  fetch_gen[1] = 3;
+  refresh_left = 1;
+  assert(!worker_result(&idle, "octo/api", 2, 200, "\"w\"",
+                        "completed failure", NULL));
+  assert(in_flight[1] && refresh_left == 1);
+  assert(worker_result(&idle, "octo/api", 3, 200, "\"w\"",
+                       "completed failure", NULL));
+  assert(!in_flight[1] && !refresh_owed[1] && refresh_left == 0);
+  assert(!fetch_current(1, 3));
+
+  // a refresh merged into one under way leaves every repo's schedule alone
+  long long active_due = now_ms() + ACTIVE_POLL_S * 1000LL;
+  schedule_at(1, active_due);
+  refresh_left = 1;
+  gh_running = gh_max; // a fetch is running and no slot is free
+  etags_dirty = false;
+  spawn_fetches();
+  assert(next_due[1] == active_due && refresh_left == 1 && fetch_qlen == 0);
+  gh_running = 0;
+  refresh_left = 0;
+  repo_table_free();
   return 0;
 }